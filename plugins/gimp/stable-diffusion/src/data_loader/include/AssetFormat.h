@@ -0,0 +1,92 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// single file container of the precomputed tensors, written by tools/AssetConverter.cpp.
+// layout, all little endian:
+//   AssetFileHeader at offset 0
+//   the tensor sections, each starting on an ASSET_SECTION_ALIGNMENT boundary
+//   the table of contents, AssetSection[section_count] at toc_offset
+// the table of contents and every section carry a crc32, the loader checks the table at load
+// and a section before its data is first used
+
+#define ASSET_FILE_MAGIC 0x4B504453  // "SDPK"
+#define ASSET_FILE_VERSION 1
+#define ASSET_FILE_EXT ".sdpk"
+
+// sections start on cache line boundaries, so that mapped tensors can be read with aligned SIMD loads
+#define ASSET_SECTION_ALIGNMENT 64
+#define ASSET_MAX_RANK 4
+
+enum class AssetKind : uint32_t
+{
+    // float32 (1, h, w, c) random initial latent, key: seed
+    LATENT = 1,
+    // int32 (steps) time steps of a schedule, key: number of steps
+    TIME_STEPS = 2,
+    // float32 (steps, 1280) ts embeddings of a schedule, key: number of steps
+    TS_EMBEDDING = 3,
+    // float32 (1, 77, 768 or 1024) text embedding of the prompt [""], key: 0
+    CONST_TEXT_EMBEDDING = 4,
+    // float32 (out, in) weight of the UNet time embedding MLP, key: 1 for linear_1, 2 for linear_2
+    TIME_MLP_WEIGHT = 5,
+    // float32 (out) bias of the UNet time embedding MLP, key: 1 for linear_1, 2 for linear_2
+    TIME_MLP_BIAS = 6
+};
+
+enum class AssetDataType : uint32_t
+{
+    FLOAT32 = 1,
+    INT32 = 2
+};
+
+// model a section belongs to, ANY sections are used by every model
+enum class AssetModel : uint32_t
+{
+    ANY = 0,
+    SD_1_5 = 1,
+    SD_2_1 = 2
+};
+
+struct AssetFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t section_count;
+    // crc32 of the AssetSection[section_count] table
+    uint32_t toc_crc32;
+    uint64_t toc_offset;
+    uint64_t file_size;
+};
+
+struct AssetSection
+{
+    uint32_t kind;
+    uint32_t data_type;
+    uint32_t model;
+    int32_t key;
+    uint32_t rank;
+    uint32_t shape[ASSET_MAX_RANK];
+    // crc32 of the size bytes at offset
+    uint32_t crc32;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(AssetFileHeader) == 32, "AssetFileHeader is part of the file format");
+static_assert(sizeof(AssetSection) == 64, "AssetSection is part of the file format");
+
+// crc32 of the IEEE 802.3 polynomial, the one of zlib. crc continues a previous call
+uint32_t asset_crc32(const void *data, size_t size, uint32_t crc = 0);
+
+// bytes per element, 0 for an unknown type
+size_t asset_element_size(uint32_t data_type);
+
+// product of the shape, 0 when the rank is out of range
+uint64_t asset_element_count(const AssetSection &section);
@@ -12,6 +12,8 @@
 #include <map>
 #include <memory>
 
+#include "TensorCodec.hpp"
+
 #ifndef float32_t
 using float32_t = float;
 #endif
@@ -20,7 +22,7 @@ using float32_t = float;
 #define TS_EMBEDDING_ELEMENT_COUNT (1 * 1280)
 #define CONST_TEXT_EMBEDDING_COUNT_SD_1_5 (1 * 77 * 768)
 #define CONST_TEXT_EMBEDDING_COUNT_SD_2_1 (1 * 77 * 1024)
-// the target order is nhwc
+// the target order is nhwc, default latent size used when load() is not given one
 #define LATENT_ELEMENT_COUNT (1 * 64 * 64 * 4)
 
 #define LATENT_BIN_FILE_EXT ".rand"
@@ -35,92 +37,214 @@ using float32_t = float;
 // flatted tensor data,
 using tensor_data_float32_t = std::vector<float32_t>;
 
+// read-only view of flatted tensor data owned by someone else, the data loader hands out views
+// into its memory mapped data file. offers the read accessors of std::vector
+template <typename T>
+class TensorView
+{
+public:
+    TensorView() = default;
+    TensorView(const T *data, size_t size) : data_(data), size_(size) {}
+    TensorView(const std::vector<T> &data) : data_(data.data()), size_(data.size()) {}
+
+    const T *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T &operator[](size_t index) const { return data_[index]; }
+    const T *begin() const { return data_; }
+    const T *end() const { return data_ + size_; }
+
+private:
+    const T *data_ = nullptr;
+    size_t size_ = 0;
+};
+using tensor_view_float32_t = TensorView<float32_t>;
+
 struct FileParser
 {
     virtual ~FileParser(){};
-    virtual bool parse(std::ifstream &fin, size_t file_size) = 0;
+    // data points to the file_size bytes of the file inside the mapped tar file, the views
+    // taken on it stay valid as long as the loader keeps the mapping
+    virtual bool parse(const char *data, size_t file_size) = 0;
 };
 
+class MappedFile;
+class LatentParser;
+class TsEmbeddingParser;
+template <typename T>
+class TensorParser;
+class TimeEmbedding;
+
+// The loaded data never changes after load(), every other method is const and can be called from
+// several threads at once without locking, so generation sessions can share one loader through a
+// std::shared_ptr<const DataLoader>. The step count is chosen per call instead of being loader state.
+// The state of a session, its ts embeddings encoded for the UNet input, is kept by TsEmbeddingCache
+
 class DataLoader
 {
 public:
     DataLoader();
     ~DataLoader();
-    // load data from files, this must be called first
+    // load data from files, this must be called first, and before the loader is shared
     // load read data from a tar file defined by enviroment variable "SD_TAR_FILE"
+    // the file is either the tar of .rand/.ts/.cte files or an asset file of AssetFormat.h,
+    // told apart by its first bytes. an asset file may hold the data of several models, only
+    // the sections of model_version are loaded
+    // the file is memory mapped, the tensors handed out point into the mapping and stay
+    // valid until the next load or the destruction of the loader.
+    // only the headers and tables of the files are read here, the tensors are first touched
+    // when they are requested, after checking the crc32 of their asset file section. the getters
+    // of a section whose crc32 doesn't match report the corruption and return false
+    // latent_element_count is the h*w*c size of the UNet latent input,
+    // 0 derives it from the size of the latent file in the tar
 
-    bool load(char *file_name = nullptr, std::string model_version=NULL);
+    bool load(char *file_name = nullptr, std::string model_version=NULL,
+              size_t latent_element_count = LATENT_ELEMENT_COUNT);
 
-    // get a list of supported number of steps
+    // number of elements in each random initial latent
 
-    void get_supported_num_steps(std::vector<int32_t> &step_seq) const;
+    size_t get_latent_element_count() const;
 
-    // what is the current number of steps used?
+    // get a list of supported number of steps, in increasing order
 
-    int32_t get_current_num_steps() const
-    {
-        return cur_num_steps_;
-    }
+    void get_supported_num_steps(std::vector<int32_t> &step_seq) const;
 
-    // set number of steps for denoising process
-    // the number must be set before denoising starts, and
-    // cannot change in the middle
+    // are there precomputed time steps and embeddings for num_steps steps?
 
-    bool set_num_steps(int32_t steps);
+    bool is_num_steps_supported(int32_t num_steps) const;
 
-    // get the time step embedding pointed by step_index
+    // get the time step embedding pointed by step_index of the num_steps step sequence
     // each embedding is a 2-d tensor of (1x1280) stored in C major order
     // returns:
     //  ts_embedding_ptr, the caller should not do delete on it
 
-    bool get_ts_embedding(uint32_t step_index,
-                          const tensor_data_float32_t *&t4_ts_embedding_ptr);
+    bool get_ts_embedding(int32_t num_steps, uint32_t step_index,
+                          const tensor_view_float32_t *&t4_ts_embedding_ptr) const;
+
+    // get the precomputed time step embedding of the given time step value, whichever step
+    // sequence holds it. Lets schedulers with their own timesteps use the embeddings,
+    // returns false when no sequence holds that time step, see TsEmbeddingCache for the others
+
+    bool get_ts_embedding_by_time_step(int32_t time_step,
+                                       const tensor_view_float32_t *&t4_ts_embedding_ptr) const;
+
+    // does the file hold the time embedding MLP of the UNet?
+
+    bool has_time_embedding_mlp() const;
+
+    // evaluate the ts embeddings of element_count elements of the time steps, back to back in
+    // embeddings. TS_EMBEDDING_ELEMENT_COUNT elements need the time embedding MLP, other counts
+    // get the bare sinusoidal projection of that many channels
 
-    // get the time step  pointed by step_index
+    bool compute_ts_embeddings(const std::vector<int32_t> &time_steps, size_t element_count,
+                               float32_t *embeddings) const;
 
-    bool get_time_step(uint32_t step_index, int32_t &t13_time_step);
+    // get the time step pointed by step_index of the num_steps step sequence
 
-    // get the time step from user provided time steps
-    bool get_time_steps(const std::vector<int32_t> *&t9_time_steps_ptr);
+    bool get_time_step(int32_t num_steps, uint32_t step_index, int32_t &t13_time_step) const;
+
+    // get the time steps of the num_steps step sequence
+    bool get_time_steps(int32_t num_steps, const std::vector<int32_t> *&t9_time_steps_ptr) const;
 
     // how many precomputed random intialized latents?
 
     int32_t get_num_initial_latents() const;
 
-    void get_seed_list(std::vector<int32_t> &seed_list);
+    void get_seed_list(std::vector<int32_t> &seed_list) const;
 
     // get the random initial latent pointed by seed_index
-    // each latent is a 4-d tensor of (1x64x64x4) stored in C major order
+    // each latent is a 4-d tensor of (1xHxWx4), 1x64x64x4 for 512x512 images, stored in C major order
     // returns:
     //   latent_ptr, the caller should not do delete on it,
 
     bool get_random_init_latent(uint32_t seed_index,
                                 int32_t &seed,
-                                const tensor_data_float32_t *&t10_latent_ptr);
+                                const tensor_view_float32_t *&t10_latent_ptr) const;
 
     // get the random initial latent pointed by seed
-    // each latent is a 4-d tensor of (1x64x64x4) stored in C major order
+    // each latent is a 4-d tensor of (1xHxWx4) stored in C major order
     // returns:
     //   latent_ptr, the caller should not do delete on it
 
     bool get_random_init_latent(int32_t seed,
-                                const tensor_data_float32_t *&t10_latent_ptr);
+                                const tensor_view_float32_t *&t10_latent_ptr) const;
 
     // get offline precomputed text embedding from input of [""] to text encoder
     // [""] length is 1 due to batch-size-1 UNET inference, the size of the data is 1x77x768 for v1.5 and 1x77x1024 for v2.1
     // returns:
     //  text_embedding_ptr, the caller should not do delete on it
 
-    bool get_unconditional_text_embedding(const tensor_data_float32_t *&t3_text_embedding_ptr);
+    bool get_unconditional_text_embedding(const tensor_view_float32_t *&t3_text_embedding_ptr) const;
 
     // for debugging purpose
 
-    void print(std::stringstream &os, uint32_t first_n_elem = 8);
+    void print(std::stringstream &os, uint32_t first_n_elem = 8) const;
 
 private:
     bool loaded_;
-    int32_t cur_num_steps_;
-    std::unique_ptr<FileParser> latent_parser_ptr_;
-    std::unique_ptr<FileParser> ts_embedding_parser_ptr_;
-    std::unique_ptr<FileParser> const_text_embedding_parser_ptr_;
+    std::unique_ptr<MappedFile> mapped_file_;
+    std::unique_ptr<LatentParser> latent_parser_ptr_;
+    std::unique_ptr<TsEmbeddingParser> ts_embedding_parser_ptr_;
+    std::unique_ptr<TensorParser<float32_t>> const_text_embedding_parser_ptr_;
+    std::unique_ptr<TimeEmbedding> time_embedding_ptr_;
+};
+
+// The ts embeddings of one session on top of a shared DataLoader, in the encoding of its UNet input.
+// Keeps the embeddings evaluated for the time steps without precomputed data and the encoded banks
+// of the recent time step sequences. Not thread safe, each session has its own
+
+class TsEmbeddingCache
+{
+public:
+    // encoding and element_count describe the UNet ts embedding input, see TensorCodec.
+    // a count other than TS_EMBEDDING_ELEMENT_COUNT means the UNet runs the time embedding MLP
+    // itself and takes the sinusoidal projection of that many channels
+
+    TsEmbeddingCache(std::shared_ptr<const DataLoader> loader, const TensorEncoding &encoding,
+                     size_t element_count = TS_EMBEDDING_ELEMENT_COUNT);
+
+    // can the ts embedding of any time step be evaluated at runtime? true when the file holds the
+    // time embedding MLP or when the UNet takes the bare projection. otherwise only the time steps
+    // of the precomputed step sequences have an embedding
+
+    bool computes_ts_embeddings() const;
+
+    // get the time step embedding of the given time step value, the precomputed one if any.
+    // The other time steps are evaluated when computes_ts_embeddings(), and kept for later
+    // requests, returns false otherwise
+
+    bool get_ts_embedding_by_time_step(int32_t time_step,
+                                       const tensor_view_float32_t *&t4_ts_embedding_ptr);
+
+    // get the ts embeddings of the given time steps in the input encoding, back to back in step order.
+    // the embeddings without precomputed data are evaluated together for the whole sequence.
+    // the bank of a time step sequence is built on its first use and kept for the next generations,
+    // up to a few banks. the least recently used one is dropped to make room for a new sequence
+    // returns:
+    //  bank_ptr, one embedding per time step as raw tensor bytes, the caller should not do delete on it
+
+    bool get_encoded_ts_embeddings(const std::vector<int32_t> &time_steps,
+                                   const std::vector<uint8_t> *&bank_ptr);
+
+private:
+    bool find_precomputed_ts_embedding(int32_t time_step, const tensor_view_float32_t *&t4_ts_embedding_ptr) const;
+    bool compute_ts_embeddings(const std::vector<int32_t> &time_steps);
+
+    std::shared_ptr<const DataLoader> loader_;
+    TensorCodec codec_;
+    size_t element_count_;
+    // evaluated embeddings by time step, at most one per training time step
+    struct ComputedTsEmbedding
+    {
+        std::vector<float32_t> data;
+        tensor_view_float32_t view;
+    };
+    std::map<int32_t, ComputedTsEmbedding> computed_ts_embeddings_;
+    struct EncodedTsBank
+    {
+        std::vector<uint8_t> data;
+        uint64_t last_use;
+    };
+    std::map<std::vector<int32_t>, EncodedTsBank> encoded_ts_banks_;
+    uint64_t bank_clock_;
 };
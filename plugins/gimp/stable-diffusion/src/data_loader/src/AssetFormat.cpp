@@ -0,0 +1,65 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+#include "AssetFormat.h"
+
+// 4 tables of 256 entries, the crc moves a 32 bit word per step
+struct Crc32Tables
+{
+    uint32_t table[4][256];
+
+    Crc32Tables()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            for (int t = 1; t < 4; t++)
+                table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xff];
+        }
+    }
+};
+
+uint32_t asset_crc32(const void* data, size_t size, uint32_t crc)
+{
+    static const Crc32Tables tables;
+    auto& t = tables.table;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (; size >= 4; size -= 4, bytes += 4)
+    {
+        crc ^= uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+        crc = t[3][crc & 0xff] ^ t[2][(crc >> 8) & 0xff] ^ t[1][(crc >> 16) & 0xff] ^ t[0][crc >> 24];
+    }
+    for (; size > 0; size--, bytes++)
+        crc = (crc >> 8) ^ t[0][(crc ^ *bytes) & 0xff];
+    return ~crc;
+}
+
+size_t asset_element_size(uint32_t data_type)
+{
+    switch (AssetDataType(data_type))
+    {
+    case AssetDataType::FLOAT32:
+    case AssetDataType::INT32:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+uint64_t asset_element_count(const AssetSection& section)
+{
+    if (section.rank == 0 || section.rank > ASSET_MAX_RANK)
+        return 0;
+    uint64_t count = 1;
+    for (uint32_t i = 0; i < section.rank; i++)
+        count *= section.shape[i];
+    return count;
+}
@@ -8,14 +8,32 @@
 #ifndef LATENT_ELEMENT_COUNT
 #define LATENT_ELEMENT_COUNT (1 * 64 * 64 * 4)
 #endif
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <unordered_map>
 #include <vector>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "Helpers.hpp"
+#include "TensorCodec.hpp"
+#include "AssetFormat.h"
 #include "DataLoader.h"
 #include "UiHelper.h"
 #ifdef WIN32
@@ -42,8 +60,11 @@
 // #define ENV_VAR_SD_TAR_FILE "SD_TAR_FILE"
 #define DEFAULT_TAR_FILE_PATH "sd_precomute_data.tar"
 
+// number of encoded Ts embedding banks kept by a TsEmbeddingCache, one per time step sequence
+#define MAX_ENCODED_TS_BANKS 4
+
 template <typename T>
-static void dump_tensor(std::stringstream& ss, std::vector<T>& tensor_data, int count)
+static void dump_tensor(std::stringstream& ss, const TensorView<T>& tensor_data, int count)
 {
     int num = std::min<int>(count, int(tensor_data.size()));
     ss << " num_elem: " << tensor_data.size();
@@ -57,13 +78,85 @@ static void dump_tensor(std::stringstream& ss, std::vector<T>& tensor_data, int
     }
 }
 
+// Read-only mapping of a whole file, backed by the page cache instead of heap copies
+class MappedFile
+{
+
+public:
+
+    explicit MappedFile(const std::string& file_name)
+    {
+#ifdef _WIN32
+        file_ = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_, &file_size) || file_size.QuadPart == 0)
+            return;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr)
+            return;
+        data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (data_ != nullptr)
+            size_ = size_t(file_size.QuadPart);
+#else
+        int fd = open(file_name.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+        {
+            void* data = mmap(nullptr, size_t(file_stat.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                data_ = static_cast<const char*>(data);
+                size_ = size_t(file_stat.st_size);
+            }
+        }
+        // the mapping keeps its own reference on the file
+        close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (data_ != nullptr)
+            UnmapViewOfFile(data_);
+        if (mapping_ != nullptr)
+            CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE)
+            CloseHandle(file_);
+#else
+        if (data_ != nullptr)
+            munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const { return data_ != nullptr; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+};
+
 class TarLoader
 {
 
 public:
 
-    explicit TarLoader(const std::string& tar_name)
-        : tar_name_(tar_name), tar_(tar_name, std::ios::binary)
+    TarLoader(const std::string& tar_name, const MappedFile& tar)
+        : tar_name_(tar_name), tar_(tar)
     {
         init();
     }
@@ -73,32 +166,36 @@ public:
         parsers_[file_ext] = parser_ptr;
     }
 
+    // indexes the members of the tar by offset and size, no file data is read here
     void init()
     {
-        MY_ASSERT(tar_.is_open(), "Error in opening %s", tar_name_.c_str());
-
         auto const TAR_HEADER_FIELD_NAME_POS = 0;
+        auto const TAR_HEADER_FIELD_NAME_LEN = 100;
         auto const TAR_HEADER_FIELD_SIZE_POS = 124;
+        auto const TAR_HEADER_FIELD_SIZE_LEN = 12;
         auto const TAR_HEADER_FIELD_TYPEFLAG_POS = 156;
         auto const BLOCKSIZE = 512;
-        char hdr[BLOCKSIZE];
 
         Files bin_files;
         Files text_files;
         bool is_text_file = false;
-        while (tar_.read(hdr, BLOCKSIZE) && hdr[0] != 0) {
+        size_t pos = 0;
+        while (pos + BLOCKSIZE <= tar_.size() && tar_.data()[pos] != 0) {
+            const char* hdr = tar_.data() + pos;
             is_text_file = false;
             MY_ASSERT(hdr[TAR_HEADER_FIELD_TYPEFLAG_POS] == '0', "Unsupported typeflag:%c", hdr[TAR_HEADER_FIELD_TYPEFLAG_POS]);
 
-            std::string filename{ hdr + TAR_HEADER_FIELD_NAME_POS };
+            const char* name = hdr + TAR_HEADER_FIELD_NAME_POS;
+            std::string filename{ name, std::find(name, name + TAR_HEADER_FIELD_NAME_LEN, '\0') };
 
             if (filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".txt") == 0)
             {
                 is_text_file = true;
             }
 
-            size_t offset = tar_.tellg();
-            uint32_t size = std::stoi(hdr + TAR_HEADER_FIELD_SIZE_POS, nullptr, 8);
+            size_t offset = pos + BLOCKSIZE;
+            uint32_t size = std::stoi(std::string(hdr + TAR_HEADER_FIELD_SIZE_POS, TAR_HEADER_FIELD_SIZE_LEN), nullptr, 8);
+            MY_ASSERT(offset + size <= tar_.size(), "%s is truncated in %s", filename.c_str(), tar_name_.c_str());
             if (is_text_file)
             {
                 text_files.emplace(filename, std::pair<size_t, uint32_t>(offset, size));
@@ -111,8 +208,7 @@ public:
                 DEMO_DEBUG("binary_files[%zu]: %s, offset:%zu, size:%u",
                     bin_files.size() - 1, filename.c_str(), offset, size);
             }
-            auto seek = (size + BLOCKSIZE - 1) / BLOCKSIZE * BLOCKSIZE;
-            tar_.seekg(seek, std::ios_base::cur);
+            pos = offset + (size + BLOCKSIZE - 1) / BLOCKSIZE * BLOCKSIZE;
         }
 
         bin_files_.swap(bin_files);
@@ -122,12 +218,8 @@ public:
             auto offset_size_pair = it->second;
             auto offset = offset_size_pair.first;
             auto size = offset_size_pair.second;
-            tar_.seekg(offset);
-            std::vector<char> text;
-            text.resize(size + 1);
-            tar_.read(reinterpret_cast<char*>(text.data()), size);
-            text[size] = '\0';
-            DEMO_DEBUG("%s", text.data());
+            std::string text(tar_.data() + offset, size);
+            DEMO_DEBUG("%s", text.c_str());
         }
     }
 
@@ -147,10 +239,9 @@ public:
                     auto offset_size_pair = file_iter->second;
                     auto offset = offset_size_pair.first;
                     auto size = offset_size_pair.second;
-                    tar_.seekg(offset);
                     auto parser_ptr = parser_iter->second;
                     DEMO_DEBUG("Invoke parser for %s", file_name.c_str());
-                    good = parser_ptr->parse(tar_, size);
+                    good = parser_ptr->parse(tar_.data() + offset, size);
                     ret = ret && good;
                 }
             }
@@ -162,7 +253,7 @@ public:
 
 private:
     const std::string tar_name_;
-    std::ifstream tar_;
+    const MappedFile& tar_;
 
     // name:pair<offset,size>
     using Files = std::unordered_map<std::string, std::pair<size_t, uint32_t>>;
@@ -170,54 +261,140 @@ private:
     std::unordered_map<std::string, FileParser*> parsers_;
 };
 
+// the tar members start on 512 byte blocks and keep their floats 4 byte aligned,
+// checked anyway before any view is taken
+template <typename T>
+static bool is_aligned_for(const char* data)
+{
+    return reinterpret_cast<uintptr_t>(data) % alignof(T) == 0;
+}
+
+// bytes of one tensor inside the mapped file, with the crc32 the container recorded for them if any
+struct TensorSource
+{
+    const char* data = nullptr;
+    size_t size = 0;
+    bool has_crc = false;
+    uint32_t crc = 0;
+
+    TensorSource() = default;
+    TensorSource(const char* data, size_t size)
+        : data(data), size(size)
+    {}
+    TensorSource(const char* data, size_t size, uint32_t crc)
+        : data(data), size(size), has_crc(true), crc(crc)
+    {}
+    TensorSource(const TensorSource& other)
+        : data(other.data), size(other.size), has_crc(other.has_crc), crc(other.crc),
+        verified_(other.verified_.load(std::memory_order_relaxed))
+    {}
+    TensorSource& operator=(const TensorSource& other)
+    {
+        data = other.data;
+        size = other.size;
+        has_crc = other.has_crc;
+        crc = other.crc;
+        verified_.store(other.verified_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    // the crc is computed on the first call only. concurrent first calls may both compute it, the
+    // result is the same, so the loaded data needs no lock
+    bool verify() const
+    {
+        if (!has_crc || verified_.load(std::memory_order_acquire))
+            return true;
+        if (asset_crc32(data, size) != crc)
+            return false;
+        verified_.store(true, std::memory_order_release);
+        return true;
+    }
+
+private:
+    mutable std::atomic<bool> verified_{ false };
+};
+
+// The parsers only index their file at load time, reading its header and table. The views are set
+// up then too, but the tensor data is first touched when a tensor is requested, after checking its
+// crc32, so loading doesn't scale with the size of the tar. Nothing changes after the load, the const
+// getters can be called from any number of threads.
+// Both containers fill them, the tar through parse() and the asset file through the add methods
 class LatentParser : public FileParser
 {
 public:
-    LatentParser() {}
+    // num_elements of 0 derives the latent size from the file size
+    LatentParser(size_t num_elements = 0)
+        :num_elements_(num_elements)
+    {}
     std::vector<int32_t> seed_seq_;
-    std::vector<tensor_data_float32_t> latent_seq_;
-    bool parse(std::ifstream& fin, size_t file_size)  override
+    // seed to its index in seed_seq_, the first latent of a seed wins
+    std::unordered_map<int32_t, uint32_t> seed_index_map_;
+    std::vector<tensor_view_float32_t> latent_seq_;
+    std::vector<TensorSource> latent_sources_;
+    size_t num_elements_;
+
+    // nullptr when the crc of the latent doesn't match, a corrupted file isn't a programming error
+    const tensor_view_float32_t* get_latent(uint32_t index) const
     {
-        int32_t count = 0;
-        size_t total_read = 0;
-        fin.read(reinterpret_cast<char*>(&count), sizeof(int32_t));
-        total_read += sizeof(int32_t);
-        int32_t seed = 0;
-        for (int32_t i = 0; i < count; i++)
+        if (!latent_sources_[index].verify())
         {
-            if (fin)
-                fin.read(reinterpret_cast<char*>(&seed), sizeof(int32_t));
-            if (fin)
-            {
-                total_read += sizeof(int32_t);
-                seed_seq_.push_back(seed);
-                DEMO_DEBUG("load seed[%d] %d ", i, seed);
-            }
+            DEMO_ERROR("random_init_latent[%u] is corrupted", index);
+            return nullptr;
+        }
+        return &latent_seq_[index];
+    }
 
+    bool add_latent(int32_t seed, const TensorSource& source)
+    {
+        if (num_elements_ == 0)
+            num_elements_ = source.size / sizeof(float32_t);
+        if (num_elements_ == 0 || source.size != sizeof(float32_t) * num_elements_)
+        {
+            DEMO_ERROR("load latent error, size mismatch: %zu vs %zu", sizeof(float32_t) * num_elements_, source.size);
+            return false;
         }
-        for (int32_t i = 0; i < count; i++)
+        if (!is_aligned_for<float32_t>(source.data))
         {
-            tensor_data_float32_t latent;
-            latent.resize(LATENT_ELEMENT_COUNT);
-            if (fin)
-                fin.read(reinterpret_cast<char*>(latent.data()),
-                    sizeof(float32_t) * LATENT_ELEMENT_COUNT);
-            if (fin)
-            {
-                total_read += sizeof(float32_t) * LATENT_ELEMENT_COUNT;
-                latent_seq_.push_back(latent);
-                DEMO_DEBUG("load random_init_latent[%d]", i);
-                std::stringstream os;
-                dump_tensor<float32_t>(os, latent, 8);
-                DEMO_DEBUG("  %s", os.str().c_str());
-            }
+            DEMO_ERROR("load latent error, misaligned data");
+            return false;
+        }
+        DEMO_DEBUG("load seed[%zu] %d ", seed_seq_.size(), seed);
+        seed_index_map_.emplace(seed, uint32_t(seed_seq_.size()));
+        seed_seq_.push_back(seed);
+        latent_sources_.push_back(source);
+        latent_seq_.emplace_back(reinterpret_cast<const float32_t*>(source.data), num_elements_);
+        return true;
+    }
 
+    bool parse(const char* data, size_t file_size)  override
+    {
+        int32_t count = 0;
+        if (file_size >= sizeof(int32_t))
+            std::memcpy(&count, data, sizeof(int32_t));
+        if (count > 0 && num_elements_ == 0)
+        {
+            size_t latent_bytes = file_size - sizeof(int32_t) * (1 + size_t(count));
+            num_elements_ = latent_bytes / (sizeof(float32_t) * count);
+            DEMO_DEBUG("derived latent size %zu from file size %zu", num_elements_, file_size);
         }
-        if (total_read != file_size)
+        size_t expected = sizeof(int32_t) * (1 + size_t(std::max<int32_t>(count, 0))) +
+            sizeof(float32_t) * num_elements_ * std::max<int32_t>(count, 0);
+        if (count <= 0 || num_elements_ == 0 || expected != file_size)
         {
-            DEMO_ERROR("load latent error, size mismatch: %zu vs %zu", total_read, file_size);
+            DEMO_ERROR("load latent error, size mismatch: %zu vs %zu", expected, file_size);
             return false;
         }
+
+        const char* seed_data = data + sizeof(int32_t);
+        const char* latent_data = seed_data + sizeof(int32_t) * count;
+        const size_t latent_bytes = sizeof(float32_t) * num_elements_;
+        for (int32_t i = 0; i < count; i++)
+        {
+            int32_t seed;
+            std::memcpy(&seed, seed_data + sizeof(int32_t) * i, sizeof(int32_t));
+            if (!add_latent(seed, TensorSource(latent_data + latent_bytes * i, latent_bytes)))
+                return false;
+        }
         return true;
     }
     virtual ~LatentParser() {}
@@ -227,57 +404,81 @@ class TsEmbeddingParser : public FileParser
 {
 public:
     TsEmbeddingParser() {}
-    std::unordered_map<int32_t, std::vector<int32_t>> ts_seq_map_;
-    std::unordered_map<int32_t, std::vector<tensor_data_float32_t>> ts_embedding_seq_map_;
+    std::map<int32_t, std::vector<int32_t>> ts_seq_map_;
+    // embeddings of every step count, back to back in step order
+    std::unordered_map<int32_t, TensorSource> ts_embedding_source_map_;
+    std::unordered_map<int32_t, std::vector<tensor_view_float32_t>> ts_embedding_seq_map_;
+    // time step value to its step count and step index, built by index_time_steps()
+    std::unordered_map<int32_t, std::pair<int32_t, uint32_t>> time_step_index_map_;
 
-    bool parse(std::ifstream& fin, size_t file_size)  override
+    // steps must be one of the indexed step counts. nullptr when the crc of the embeddings doesn't match
+    const std::vector<tensor_view_float32_t>* get_ts_embeddings(int32_t steps) const
     {
-        int32_t steps = 0;
-        size_t total_read = 0;
-        if (fin)
+        if (!ts_embedding_source_map_.at(steps).verify())
         {
-            fin.read(reinterpret_cast<char*>(&steps), sizeof(int32_t));
+            DEMO_ERROR("ts_embedding of %d steps is corrupted", steps);
+            return nullptr;
         }
-        if (fin)
-        {
-            total_read += sizeof(int32_t);
-            ts_seq_map_.emplace(std::pair<int32_t, std::vector<int32_t>>(steps, {}));
-            ts_seq_map_[steps].resize(steps);
+        return &ts_embedding_seq_map_.at(steps);
+    }
 
-            fin.read(reinterpret_cast<char*>(ts_seq_map_[steps].data()), sizeof(int32_t) * steps);
-        }
-        if (fin)
+    // a time step in several sequences has the same embedding in each, the smallest step count is
+    // indexed, to check a single sequence. called once all the steps are added
+    void index_time_steps()
+    {
+        time_step_index_map_.clear();
+        for (auto const& element : ts_seq_map_)
         {
-            total_read += sizeof(int32_t) * steps;
-            ts_embedding_seq_map_.emplace(std::pair<int32_t, std::vector<tensor_data_float32_t>>(steps, {}));
-            ts_embedding_seq_map_[steps].resize(steps);
+            for (uint32_t i = 0; i < element.second.size(); i++)
+                time_step_index_map_.emplace(element.second[i], std::make_pair(element.first, i));
+        }
+    }
 
-            for (int32_t idx = 0; idx < steps; idx++)
-            {
-                ts_embedding_seq_map_[steps][idx].resize(TS_EMBEDDING_ELEMENT_COUNT);
-                if (fin)
-                {
-                    fin.read(reinterpret_cast<char*>(ts_embedding_seq_map_[steps][idx].data()),
-                        sizeof(float32_t) * TS_EMBEDDING_ELEMENT_COUNT);
-                }
-                if (fin)
-                {
-                    total_read += sizeof(float32_t) * TS_EMBEDDING_ELEMENT_COUNT;
-                    DEMO_DEBUG("load ts_embedding %d/%d steps", idx + 1, steps);
-                    std::stringstream os;
-                    dump_tensor<float32_t>(os, ts_embedding_seq_map_[steps][idx], 8);
-                    DEMO_DEBUG("  %s", os.str().c_str());
-                }
-            }
+    // time_steps holds steps int32 values, without alignment requirement
+    bool add_steps(int32_t steps, const char* time_steps, const TensorSource& embeddings)
+    {
+        if (steps <= 0 || embeddings.size != sizeof(float32_t) * TS_EMBEDDING_ELEMENT_COUNT * size_t(steps))
+        {
+            DEMO_ERROR("load ts_embedding error, size mismatch: %zu vs %zu",
+                sizeof(float32_t) * TS_EMBEDDING_ELEMENT_COUNT * size_t(std::max<int32_t>(steps, 0)), embeddings.size);
+            return false;
         }
-        if (total_read != file_size)
+        if (!is_aligned_for<float32_t>(embeddings.data))
         {
-            DEMO_ERROR("load ts_embedding error, size mismatch: %zu vs %zu", total_read, file_size);
+            DEMO_ERROR("load ts_embedding error, misaligned data");
             return false;
         }
+
+        auto& ts_seq = ts_seq_map_[steps];
+        ts_seq.resize(steps);
+        std::memcpy(ts_seq.data(), time_steps, sizeof(int32_t) * steps);
+
+        ts_embedding_source_map_[steps] = embeddings;
+        auto& ts_embedding_seq = ts_embedding_seq_map_[steps];
+        ts_embedding_seq.clear();
+        const float32_t* embedding_data = reinterpret_cast<const float32_t*>(embeddings.data);
+        for (int32_t idx = 0; idx < steps; idx++)
+            ts_embedding_seq.emplace_back(embedding_data + TS_EMBEDDING_ELEMENT_COUNT * idx, TS_EMBEDDING_ELEMENT_COUNT);
         return true;
     }
 
+    bool parse(const char* data, size_t file_size)  override
+    {
+        int32_t steps = 0;
+        if (file_size >= sizeof(int32_t))
+            std::memcpy(&steps, data, sizeof(int32_t));
+        size_t expected = sizeof(int32_t) * (1 + size_t(std::max<int32_t>(steps, 0))) +
+            sizeof(float32_t) * TS_EMBEDDING_ELEMENT_COUNT * std::max<int32_t>(steps, 0);
+        if (steps <= 0 || expected != file_size)
+        {
+            DEMO_ERROR("load ts_embedding error, size mismatch: %zu vs %zu", expected, file_size);
+            return false;
+        }
+        const char* embedding_data = data + sizeof(int32_t) * (1 + size_t(steps));
+        return add_steps(steps, data + sizeof(int32_t),
+            TensorSource(embedding_data, sizeof(float32_t) * TS_EMBEDDING_ELEMENT_COUNT * steps));
+    }
+
     virtual ~TsEmbeddingParser() {}
 };
 
@@ -285,7 +486,7 @@ template <typename T>
 class TensorParser : public FileParser
 {
 public:
-    std::vector<T> tensor_data_;
+    TensorView<T> tensor_data_;
     size_t num_elements_;
     std::string name_;
 
@@ -293,16 +494,17 @@ public:
         :num_elements_(num_elements), name_(name)
     {}
 
-    bool parse(std::ifstream& fin, size_t file_size)  override
+    // the tensor is read at Init anyway, its crc is checked right away
+    bool set_tensor(const TensorSource& source)
     {
-        if (fin)
-        {
-            tensor_data_.resize(num_elements_);
-            fin.read(reinterpret_cast<char*>(tensor_data_.data()),
-                sizeof(T) * num_elements_);
-        }
-        if (fin)
+        if (source.size >= sizeof(T) * num_elements_ && is_aligned_for<T>(source.data))
         {
+            if (!source.verify())
+            {
+                DEMO_ERROR("load %s failed, the data is corrupted", name_.c_str());
+                return false;
+            }
+            tensor_data_ = TensorView<T>(reinterpret_cast<const T*>(source.data), num_elements_);
             DEMO_DEBUG("load %s size %zu", name_.c_str(), num_elements_);
             std::stringstream os;
             dump_tensor<T>(os, tensor_data_, 8);
@@ -315,12 +517,295 @@ public:
             return false;
         }
     }
+
+    bool parse(const char* data, size_t file_size)  override
+    {
+        return set_tensor(TensorSource(data, file_size));
+    }
     virtual ~TensorParser() {}
 };
 
+// Timestep embedding of the diffusers UNet2DConditionModel evaluated on the CPU, for the time steps
+// without a precomputed embedding. The sinusoidal projection uses flip_sin_to_cos and no frequency
+// shift like SD 1.5 and 2.1 and runs in float32 like torch. The time_embedding MLP, linear_1, SiLU
+// and linear_2, follows when its weights are in the asset file
+class TimeEmbedding
+{
+public:
+    TensorView<float32_t> linear_1_weight_, linear_1_bias_, linear_2_weight_, linear_2_bias_;
+    // weights, biases of linear_1 then linear_2, checked on the first evaluation
+    TensorSource sources_[4];
+
+    bool has_mlp() const
+    {
+        return !linear_2_bias_.empty();
+    }
+
+    // the weights come as (out, in) matrices, the MLP must map its input channels to
+    // TS_EMBEDDING_ELEMENT_COUNT outputs
+    bool set_mlp(const TensorSource& weight_1, const TensorSource& bias_1, const TensorSource& weight_2,
+        const TensorSource& bias_2)
+    {
+        const size_t hidden = bias_1.size / sizeof(float32_t);
+        const size_t in_channels = hidden > 0 ? weight_1.size / sizeof(float32_t) / hidden : 0;
+        if (hidden == 0 || in_channels == 0 || in_channels % 2 != 0 ||
+            weight_1.size != sizeof(float32_t) * hidden * in_channels ||
+            bias_2.size != sizeof(float32_t) * TS_EMBEDDING_ELEMENT_COUNT ||
+            weight_2.size != sizeof(float32_t) * TS_EMBEDDING_ELEMENT_COUNT * hidden)
+        {
+            DEMO_ERROR("load time embedding MLP error, inconsistent shapes");
+            return false;
+        }
+        const TensorSource sources[4] = { weight_1, bias_1, weight_2, bias_2 };
+        for (int i = 0; i < 4; i++)
+        {
+            if (!is_aligned_for<float32_t>(sources[i].data))
+            {
+                DEMO_ERROR("load time embedding MLP error, misaligned data");
+                return false;
+            }
+            sources_[i] = sources[i];
+        }
+        linear_1_weight_ = TensorView<float32_t>(reinterpret_cast<const float32_t*>(weight_1.data), hidden * in_channels);
+        linear_1_bias_ = TensorView<float32_t>(reinterpret_cast<const float32_t*>(bias_1.data), hidden);
+        linear_2_weight_ = TensorView<float32_t>(reinterpret_cast<const float32_t*>(weight_2.data), TS_EMBEDDING_ELEMENT_COUNT * hidden);
+        linear_2_bias_ = TensorView<float32_t>(reinterpret_cast<const float32_t*>(bias_2.data), TS_EMBEDDING_ELEMENT_COUNT);
+        DEMO_DEBUG("load time embedding MLP %zu -> %zu -> %d", in_channels, hidden, TS_EMBEDDING_ELEMENT_COUNT);
+        return true;
+    }
+
+    // evaluates the embeddings of output_count elements of every time step, back to back in out.
+    // the MLP output is produced when output_count is TS_EMBEDDING_ELEMENT_COUNT, the bare
+    // projection of output_count channels otherwise
+    bool compute(const std::vector<int32_t>& time_steps, size_t output_count, float32_t* out) const
+    {
+        const size_t count = time_steps.size();
+        if (output_count != TS_EMBEDDING_ELEMENT_COUNT)
+        {
+            if (output_count == 0 || output_count % 2 != 0)
+                return false;
+            for (size_t n = 0; n < count; n++)
+                project(time_steps[n], output_count, out + n * output_count);
+            return true;
+        }
+        if (!has_mlp())
+            return false;
+        for (auto& source : sources_)
+        {
+            if (!source.verify())
+            {
+                DEMO_ERROR("time embedding MLP is corrupted");
+                return false;
+            }
+        }
+
+        const size_t hidden = linear_1_bias_.size();
+        const size_t in_channels = linear_1_weight_.size() / hidden;
+        std::vector<float32_t> projection(count * in_channels), hidden_state(count * hidden);
+        for (size_t n = 0; n < count; n++)
+            project(time_steps[n], in_channels, projection.data() + n * in_channels);
+        linear(projection.data(), count, in_channels, linear_1_weight_.data(), linear_1_bias_.data(), hidden,
+            hidden_state.data());
+        for (auto& value : hidden_state)
+            value = value / (1.0f + std::exp(-value));
+        linear(hidden_state.data(), count, hidden, linear_2_weight_.data(), linear_2_bias_.data(),
+            TS_EMBEDDING_ELEMENT_COUNT, out);
+        return true;
+    }
+
+private:
+    // get_timestep_embedding of diffusers: cos then sin of t * 10000^(-i / half)
+    static void project(int32_t time_step, size_t channels, float32_t* out)
+    {
+        const size_t half = channels / 2;
+        const float32_t log_max_period = -std::log(10000.0f);
+        for (size_t i = 0; i < half; i++)
+        {
+            const float32_t frequency = std::exp(log_max_period * float32_t(i) / float32_t(half));
+            const float32_t angle = float32_t(time_step) * frequency;
+            out[i] = std::cos(angle);
+            out[half + i] = std::sin(angle);
+        }
+    }
+
+    // out[n] = weight * in[n] + bias for count inputs at once, so that each weight row is read once.
+    // the 8 partial sums let the compiler vectorize the dot products
+    static void linear(const float32_t* in, size_t count, size_t in_features, const float32_t* weight,
+        const float32_t* bias, size_t out_features, float32_t* out)
+    {
+        for (size_t o = 0; o < out_features; o++)
+        {
+            const float32_t* w = weight + o * in_features;
+            for (size_t n = 0; n < count; n++)
+            {
+                const float32_t* x = in + n * in_features;
+                float32_t sums[8] = { 0 };
+                size_t i = 0;
+                for (; i + 8 <= in_features; i += 8)
+                {
+                    for (int k = 0; k < 8; k++)
+                        sums[k] += w[i + k] * x[i + k];
+                }
+                float32_t sum = ((sums[0] + sums[4]) + (sums[1] + sums[5])) + ((sums[2] + sums[6]) + (sums[3] + sums[7]));
+                for (; i < in_features; i++)
+                    sum += w[i] * x[i];
+                out[n * out_features + o] = sum + bias[o];
+            }
+        }
+    }
+};
+
+// Reads the single file container of AssetFormat.h. The table of contents is checked and indexed at
+// load, the sections of the requested model go to the parsers with their crc32, which is checked
+// on the first use of the section
+class AssetLoader
+{
+
+public:
+
+    AssetLoader(const std::string& file_name, const MappedFile& file)
+        : file_name_(file_name), file_(file)
+    {
+        init();
+    }
+
+    static bool is_asset_file(const MappedFile& file)
+    {
+        uint32_t magic = 0;
+        if (file.size() >= sizeof(magic))
+            std::memcpy(&magic, file.data(), sizeof(magic));
+        return magic == ASSET_FILE_MAGIC;
+    }
+
+    void init()
+    {
+        AssetFileHeader header;
+        MY_ASSERT(file_.size() >= sizeof(header), "%s is truncated", file_name_.c_str());
+        std::memcpy(&header, file_.data(), sizeof(header));
+        MY_ASSERT(header.magic == ASSET_FILE_MAGIC && header.version == ASSET_FILE_VERSION,
+            "%s is not an asset file of version %d", file_name_.c_str(), ASSET_FILE_VERSION);
+        MY_ASSERT(header.file_size == file_.size(), "%s is truncated", file_name_.c_str());
+
+        const uint64_t toc_size = uint64_t(header.section_count) * sizeof(AssetSection);
+        MY_ASSERT(header.toc_offset >= sizeof(header) && header.toc_offset <= file_.size() &&
+            toc_size <= file_.size() - header.toc_offset, "%s has no valid table of contents", file_name_.c_str());
+        const char* toc = file_.data() + header.toc_offset;
+        MY_ASSERT(asset_crc32(toc, size_t(toc_size)) == header.toc_crc32,
+            "%s table of contents is corrupted", file_name_.c_str());
+
+        sections_.resize(header.section_count);
+        std::memcpy(sections_.data(), toc, size_t(toc_size));
+        for (size_t i = 0; i < sections_.size(); i++)
+        {
+            auto& section = sections_[i];
+            const uint64_t expected = asset_element_count(section) * asset_element_size(section.data_type);
+            MY_ASSERT(section.offset % ASSET_SECTION_ALIGNMENT == 0 && section.offset <= header.toc_offset &&
+                section.size <= header.toc_offset - section.offset,
+                "section %zu of %s is out of bounds", i, file_name_.c_str());
+            MY_ASSERT(expected != 0 && expected == section.size, "section %zu of %s has size %llu, shape of %llu bytes",
+                i, file_name_.c_str(), (unsigned long long)section.size, (unsigned long long)expected);
+            DEMO_DEBUG("sections[%zu]: kind:%u, model:%u, key:%d, offset:%llu, size:%llu", i, section.kind,
+                section.model, section.key, (unsigned long long)section.offset, (unsigned long long)section.size);
+        }
+    }
+
+    // hands the sections of model, and the ones shared by every model, to the parsers
+    bool parse(AssetModel model, LatentParser& latent_parser, TsEmbeddingParser& ts_embedding_parser,
+        TensorParser<float32_t>& const_text_embedding_parser, TimeEmbedding& time_embedding)
+    {
+        bool ret = true;
+        bool has_const_text_embedding = false;
+        std::map<int32_t, const AssetSection*> time_steps;
+        std::map<int32_t, const AssetSection*> ts_embeddings;
+        // weight and bias of linear_1 then linear_2
+        const AssetSection* time_mlp[4] = { nullptr, nullptr, nullptr, nullptr };
+        for (auto& section : sections_)
+        {
+            if (AssetModel(section.model) != AssetModel::ANY && AssetModel(section.model) != model)
+                continue;
+            switch (AssetKind(section.kind))
+            {
+            case AssetKind::LATENT:
+                ret = section.data_type == uint32_t(AssetDataType::FLOAT32) &&
+                    latent_parser.add_latent(section.key, source_of(section)) && ret;
+                break;
+            case AssetKind::TIME_STEPS:
+                ret = section.data_type == uint32_t(AssetDataType::INT32) && ret;
+                time_steps[section.key] = &section;
+                break;
+            case AssetKind::TS_EMBEDDING:
+                ret = section.data_type == uint32_t(AssetDataType::FLOAT32) && ret;
+                ts_embeddings[section.key] = &section;
+                break;
+            case AssetKind::CONST_TEXT_EMBEDDING:
+                ret = section.data_type == uint32_t(AssetDataType::FLOAT32) && !has_const_text_embedding &&
+                    const_text_embedding_parser.set_tensor(source_of(section)) && ret;
+                has_const_text_embedding = true;
+                break;
+            case AssetKind::TIME_MLP_WEIGHT:
+            case AssetKind::TIME_MLP_BIAS:
+                ret = section.data_type == uint32_t(AssetDataType::FLOAT32) && (section.key == 1 || section.key == 2) && ret;
+                if (section.key == 1 || section.key == 2)
+                    time_mlp[(section.key - 1) * 2 + (AssetKind(section.kind) == AssetKind::TIME_MLP_BIAS ? 1 : 0)] = &section;
+                break;
+            default:
+                DEMO_DEBUG("skip section of unknown kind %u", section.kind);
+                break;
+            }
+        }
+
+        for (auto& element : time_steps)
+        {
+            auto& section = *element.second;
+            auto embedding_it = ts_embeddings.find(element.first);
+            if (embedding_it == ts_embeddings.end() ||
+                section.size != sizeof(int32_t) * size_t(std::max<int32_t>(element.first, 0)))
+            {
+                DEMO_ERROR("time steps of %d steps have no matching ts_embedding", element.first);
+                ret = false;
+                continue;
+            }
+            // the time steps are copied right away, check them now
+            if (!source_of(section).verify())
+            {
+                DEMO_ERROR("time steps of %d steps are corrupted", element.first);
+                ret = false;
+                continue;
+            }
+            ret = ts_embedding_parser.add_steps(element.first, file_.data() + section.offset,
+                source_of(*embedding_it->second)) && ret;
+        }
+
+        if (time_mlp[0] != nullptr || time_mlp[1] != nullptr || time_mlp[2] != nullptr || time_mlp[3] != nullptr)
+        {
+            if (time_mlp[0] == nullptr || time_mlp[1] == nullptr || time_mlp[2] == nullptr || time_mlp[3] == nullptr)
+            {
+                DEMO_ERROR("time embedding MLP misses a weight or a bias");
+                ret = false;
+            }
+            else
+            {
+                ret = time_embedding.set_mlp(source_of(*time_mlp[0]), source_of(*time_mlp[1]),
+                    source_of(*time_mlp[2]), source_of(*time_mlp[3])) && ret;
+            }
+        }
+        return ret;
+    }
+
+private:
+    TensorSource source_of(const AssetSection& section) const
+    {
+        return TensorSource(file_.data() + section.offset, size_t(section.size), section.crc32);
+    }
+
+    const std::string file_name_;
+    const MappedFile& file_;
+    std::vector<AssetSection> sections_;
+};
+
 
 DataLoader::DataLoader()
-    :loaded_(false), cur_num_steps_(20)
+    :loaded_(false)
 {
 
 }
@@ -331,7 +816,7 @@ DataLoader::~DataLoader()
 }
 
 
-bool DataLoader::load(char* file_name, std::string model_version)
+bool DataLoader::load(char* file_name, std::string model_version, size_t latent_element_count)
 {
     int embedding_count=0;
     if (model_version == VERSION_2_1)
@@ -348,165 +833,219 @@ bool DataLoader::load(char* file_name, std::string model_version)
     }
 
     DEMO_DEBUG("load %s ...", file_name);
-    TarLoader tar_loader(file_name);
+    std::unique_ptr<MappedFile> mapped_file(new MappedFile(file_name));
+    MY_ASSERT(mapped_file->is_open(), "Error in opening %s", file_name);
 
-    // register parsers
-    std::unique_ptr<FileParser> temp(new LatentParser());
-    latent_parser_ptr_ = std::move(temp);
-    tar_loader.register_parser(LATENT_BIN_FILE_EXT, latent_parser_ptr_.get());
+    latent_parser_ptr_.reset(new LatentParser(latent_element_count));
+    ts_embedding_parser_ptr_.reset(new TsEmbeddingParser());
+    const_text_embedding_parser_ptr_.reset(new TensorParser<float32_t>("const text embedding", embedding_count));
+    time_embedding_ptr_.reset(new TimeEmbedding());
+    if (AssetLoader::is_asset_file(*mapped_file))
+    {
+        AssetLoader asset_loader(file_name, *mapped_file);
+        AssetModel model = model_version == VERSION_2_1 ? AssetModel::SD_2_1 : AssetModel::SD_1_5;
+        loaded_ = asset_loader.parse(model, *latent_parser_ptr_, *ts_embedding_parser_ptr_,
+            *const_text_embedding_parser_ptr_, *time_embedding_ptr_);
+    }
+    else
+    {
+        TarLoader tar_loader(file_name, *mapped_file);
 
-    std::unique_ptr<FileParser> temp2(new TsEmbeddingParser());
-    ts_embedding_parser_ptr_ = std::move(temp2);
-    tar_loader.register_parser(TIME_STEP_EMBEDDING_BIN_FILE_EXT, ts_embedding_parser_ptr_.get());
+        // register parsers
+        tar_loader.register_parser(LATENT_BIN_FILE_EXT, latent_parser_ptr_.get());
+        tar_loader.register_parser(TIME_STEP_EMBEDDING_BIN_FILE_EXT, ts_embedding_parser_ptr_.get());
+        tar_loader.register_parser(CONST_TEXT_EMBEDDING_BIN_FILE_EXT, const_text_embedding_parser_ptr_.get());
 
-    std::unique_ptr<FileParser> temp3(new TensorParser<float32_t>("const text embedding", embedding_count));
-    const_text_embedding_parser_ptr_ = std::move(temp3);
-    tar_loader.register_parser(CONST_TEXT_EMBEDDING_BIN_FILE_EXT, const_text_embedding_parser_ptr_.get());
+        loaded_ = tar_loader.parse();
+    }
+    // the parsed tensors are views into the mapping, keep it alive with them
+    mapped_file_ = std::move(mapped_file);
+    ts_embedding_parser_ptr_->index_time_steps();
 
-    loaded_ = tar_loader.parse();
-    if (loaded_)
-        cur_num_steps_ = dynamic_cast<TsEmbeddingParser*>(ts_embedding_parser_ptr_.get())->ts_seq_map_.begin()->first;
+    // the latents are optional, the pipeline can generate the initial latent of a seed, and the ts
+    // embeddings when the time embedding MLP is there
+    if ((ts_embedding_parser_ptr_->ts_seq_map_.empty() && !time_embedding_ptr_->has_mlp()) ||
+        const_text_embedding_parser_ptr_->tensor_data_.empty())
+    {
+        DEMO_ERROR("%s misses ts embeddings or the const text embedding", file_name);
+        loaded_ = false;
+    }
     return loaded_;
 }
 
 void DataLoader::get_supported_num_steps(std::vector<int32_t>& step_seq) const
 {
     step_seq.clear();
-    for (auto const& element : dynamic_cast<TsEmbeddingParser*>(ts_embedding_parser_ptr_.get())->ts_embedding_seq_map_)
+    if (!loaded_)
+        return;
+    for (auto const& element : ts_embedding_parser_ptr_->ts_seq_map_)
     {
         step_seq.push_back(element.first);
     }
 
 }
-bool DataLoader::set_num_steps(int32_t steps)
+
+bool DataLoader::is_num_steps_supported(int32_t num_steps) const
 {
     if (!loaded_)
         return false;
+    auto& ts_dict = ts_embedding_parser_ptr_->ts_seq_map_;
+    return ts_dict.find(num_steps) != ts_dict.end();
+}
 
-    auto& ts_dict = dynamic_cast<TsEmbeddingParser*>(ts_embedding_parser_ptr_.get())->ts_seq_map_;
-    if (ts_dict.find(steps) == ts_dict.end())
-    {
-        DEMO_ERROR("Set number of steps failed, %d is not supported, stay with %d",
-            steps, cur_num_steps_);
-        return false;
-    }
-    cur_num_steps_ = steps;
-    DEMO_DEBUG("Set number of steps to %d", steps);
-    return true;
+size_t DataLoader::get_latent_element_count() const
+{
+    if (!loaded_)
+        return 0;
+    return latent_parser_ptr_->num_elements_;
 }
 
-void DataLoader::get_seed_list(std::vector<int32_t>& seed_list)
+void DataLoader::get_seed_list(std::vector<int32_t>& seed_list) const
 {
-    auto& v = dynamic_cast<LatentParser*>(latent_parser_ptr_.get())->seed_seq_;
-    seed_list = v;
+    seed_list.clear();
+    if (loaded_)
+        seed_list = latent_parser_ptr_->seed_seq_;
 }
 
 int32_t DataLoader::get_num_initial_latents() const
 {
-    auto& latent_seq = dynamic_cast<LatentParser*>(latent_parser_ptr_.get())->latent_seq_;
-    return int32_t(latent_seq.size());
+    if (!loaded_)
+        return 0;
+    return int32_t(latent_parser_ptr_->latent_seq_.size());
 }
 
 bool DataLoader::get_random_init_latent(uint32_t seed_index,
     int32_t& seed,
-    const tensor_data_float32_t*& t10_latent_ptr)
+    const tensor_view_float32_t*& t10_latent_ptr) const
 {
     if (!loaded_)
         return false;
-    auto& latent_seq = dynamic_cast<LatentParser*>(latent_parser_ptr_.get())->latent_seq_;
-    auto& seed_seq = dynamic_cast<LatentParser*>(latent_parser_ptr_.get())->seed_seq_;
-    MY_ASSERT(seed_index < latent_seq.size(), "index %u too large", seed_index);
-    seed_index = std::min<uint32_t>(seed_index, uint32_t(latent_seq.size() - 1));
+    auto& seed_seq = latent_parser_ptr_->seed_seq_;
+    MY_ASSERT(seed_index < seed_seq.size(), "index %u too large", seed_index);
+    seed_index = std::min<uint32_t>(seed_index, uint32_t(seed_seq.size() - 1));
     seed = seed_seq[seed_index];
-    t10_latent_ptr = &(latent_seq[seed_index]);
-    return true;
+    t10_latent_ptr = latent_parser_ptr_->get_latent(seed_index);
+    return t10_latent_ptr != nullptr;
 }
 
 bool DataLoader::get_random_init_latent(int32_t seed,
-    const tensor_data_float32_t*& t10_latent_ptr)
+    const tensor_view_float32_t*& t10_latent_ptr) const
 {
-    auto& latent_seq = dynamic_cast<LatentParser*>(latent_parser_ptr_.get())->latent_seq_;
-    auto& seed_seq = dynamic_cast<LatentParser*>(latent_parser_ptr_.get())->seed_seq_;
+    if (!loaded_)
+        return false;
+    auto& seed_index_map = latent_parser_ptr_->seed_index_map_;
+    auto index_it = seed_index_map.find(seed);
+    MY_ASSERT(index_it != seed_index_map.end(), "seed %d not found", seed);
+    t10_latent_ptr = latent_parser_ptr_->get_latent(index_it->second);
+    return t10_latent_ptr != nullptr;
+}
 
-    for (uint32_t i = 0; i < seed_seq.size(); i++)
+bool DataLoader::get_ts_embedding(int32_t num_steps, uint32_t step_index,
+    const tensor_view_float32_t*& t4_ts_embedding_ptr) const
+{
+    if (!is_num_steps_supported(num_steps))
     {
-        if (seed_seq[i] == seed)
-        {
-            t10_latent_ptr = &(latent_seq[i]);
-            return true;
-        }
+        DEMO_ERROR("%d steps are not supported", num_steps);
+        return false;
     }
-    MY_ASSERT(false, "seed %d not found", seed);
-    return false;
+    auto ts_embedding_seq = ts_embedding_parser_ptr_->get_ts_embeddings(num_steps);
+    if (ts_embedding_seq == nullptr)
+        return false;
+    MY_ASSERT(step_index < ts_embedding_seq->size(), "step_index %u out of boundary", step_index);
+    step_index = std::min<uint32_t>(step_index, uint32_t(ts_embedding_seq->size() - 1));
+    t4_ts_embedding_ptr = &((*ts_embedding_seq)[step_index]);
+
+    return true;
 }
 
-bool DataLoader::get_ts_embedding(uint32_t step_index,
-    const tensor_data_float32_t*& t4_ts_embedding_ptr)
+bool DataLoader::get_ts_embedding_by_time_step(int32_t time_step,
+    const tensor_view_float32_t*& t4_ts_embedding_ptr) const
 {
     if (!loaded_)
         return false;
-    auto& ts_embedding_dict = dynamic_cast<TsEmbeddingParser*>(ts_embedding_parser_ptr_.get())->ts_embedding_seq_map_;
-    MY_ASSERT(step_index < ts_embedding_dict[cur_num_steps_].size(), "step_index %u out of boundary", step_index);
-    step_index = std::min<uint32_t>(step_index, uint32_t(ts_embedding_dict[cur_num_steps_].size() - 1));
-    t4_ts_embedding_ptr = &(ts_embedding_dict[cur_num_steps_][step_index]);
-
+    auto& time_step_index_map = ts_embedding_parser_ptr_->time_step_index_map_;
+    auto index_it = time_step_index_map.find(time_step);
+    if (index_it == time_step_index_map.end())
+        return false;
+    auto ts_embedding_seq = ts_embedding_parser_ptr_->get_ts_embeddings(index_it->second.first);
+    if (ts_embedding_seq == nullptr)
+        return false;
+    t4_ts_embedding_ptr = &((*ts_embedding_seq)[index_it->second.second]);
     return true;
 }
 
-bool DataLoader::get_time_step(uint32_t step_index, int32_t& t13_time_step)
+bool DataLoader::has_time_embedding_mlp() const
+{
+    return loaded_ && time_embedding_ptr_->has_mlp();
+}
+
+bool DataLoader::compute_ts_embeddings(const std::vector<int32_t>& time_steps, size_t element_count,
+    float32_t* embeddings) const
 {
     if (!loaded_)
         return false;
-    auto& ts_dict = dynamic_cast<TsEmbeddingParser*>(ts_embedding_parser_ptr_.get())->ts_seq_map_;
-    MY_ASSERT(step_index < ts_dict[cur_num_steps_].size(), "step_size %u out of bound", step_index);
-    step_index = std::min<uint32_t>(step_index, uint32_t(ts_dict[cur_num_steps_].size() - 1));
-    t13_time_step = ts_dict[cur_num_steps_][step_index];
+    return time_embedding_ptr_->compute(time_steps, element_count, embeddings);
+}
+
+bool DataLoader::get_time_step(int32_t num_steps, uint32_t step_index, int32_t& t13_time_step) const
+{
+    if (!is_num_steps_supported(num_steps))
+    {
+        DEMO_ERROR("%d steps are not supported", num_steps);
+        return false;
+    }
+    auto& ts_seq = ts_embedding_parser_ptr_->ts_seq_map_.at(num_steps);
+    MY_ASSERT(step_index < ts_seq.size(), "step_size %u out of bound", step_index);
+    step_index = std::min<uint32_t>(step_index, uint32_t(ts_seq.size() - 1));
+    t13_time_step = ts_seq[step_index];
     return true;
 }
 
-bool DataLoader::get_time_steps(const std::vector<int32_t>*& t9_time_steps_ptr)
+bool DataLoader::get_time_steps(int32_t num_steps, const std::vector<int32_t>*& t9_time_steps_ptr) const
 {
-    if (!loaded_)
+    if (!is_num_steps_supported(num_steps))
+    {
+        DEMO_ERROR("%d steps are not supported", num_steps);
         return false;
-    auto& ts_dict = dynamic_cast<TsEmbeddingParser*>(ts_embedding_parser_ptr_.get())->ts_seq_map_;
-    t9_time_steps_ptr = &(ts_dict[cur_num_steps_]);
+    }
+    t9_time_steps_ptr = &(ts_embedding_parser_ptr_->ts_seq_map_.at(num_steps));
     return true;
 }
 
 
-bool DataLoader::get_unconditional_text_embedding(const tensor_data_float32_t*& t3_text_embedding_ptr)
+bool DataLoader::get_unconditional_text_embedding(const tensor_view_float32_t*& t3_text_embedding_ptr) const
 {
     if (!loaded_)
         return false;
-    auto& v = dynamic_cast<TensorParser<float32_t>*>(const_text_embedding_parser_ptr_.get())->tensor_data_;
-    t3_text_embedding_ptr = &(v);
+    t3_text_embedding_ptr = &(const_text_embedding_parser_ptr_->tensor_data_);
     return true;
 }
 
 // for debugging purpose
-void DataLoader::print(std::stringstream& os, uint32_t first_n_elem)
+void DataLoader::print(std::stringstream& os, uint32_t first_n_elem) const
 {
-    auto& ts_dict = dynamic_cast<TsEmbeddingParser*>(ts_embedding_parser_ptr_.get())->ts_seq_map_;
-    auto& ts_embedding_dict = dynamic_cast<TsEmbeddingParser*>(ts_embedding_parser_ptr_.get())->ts_embedding_seq_map_;
-    auto& latent_seq = dynamic_cast<LatentParser*>(latent_parser_ptr_.get())->latent_seq_;
-    auto& seed_seq = dynamic_cast<LatentParser*>(latent_parser_ptr_.get())->seed_seq_;
-    auto& const_text_embedding = dynamic_cast<TensorParser<float32_t>*>(const_text_embedding_parser_ptr_.get())->tensor_data_;
     if (!loaded_)
     {
         os << "[loaded: false]";
         return;
     }
+    auto& ts_dict = ts_embedding_parser_ptr_->ts_seq_map_;
+    auto& seed_seq = latent_parser_ptr_->seed_seq_;
+    auto& const_text_embedding = const_text_embedding_parser_ptr_->tensor_data_;
     for (auto map_iter = ts_dict.begin(); map_iter != ts_dict.end(); ++map_iter)
     {
         auto num_steps = map_iter->first;
-        auto ts_seq = map_iter->second;
-        auto ts_embedding_seq = ts_embedding_dict[num_steps];
+        auto& ts_seq = map_iter->second;
+        auto ts_embedding_seq = ts_embedding_parser_ptr_->get_ts_embeddings(num_steps);
         os << "NUM_STEPS: " << num_steps << std::endl;
         for (int i = 0; i < num_steps; i++)
         {
             os << "  step " << i + 1 << "/" << num_steps << ": ts " << ts_seq[i] << std::endl;
             os << "    ";
-            dump_tensor<float32_t>(os, ts_embedding_seq[i], first_n_elem);
+            if (ts_embedding_seq != nullptr)
+                dump_tensor<float32_t>(os, (*ts_embedding_seq)[i], first_n_elem);
+            else
+                os << "[corrupted]";
             os << std::endl;
         }
     }
@@ -515,9 +1054,124 @@ void DataLoader::print(std::stringstream& os, uint32_t first_n_elem)
     for (uint32_t i = 0; i < count; i++)
     {
         os << "  SEED[" << i << "]: " << seed_seq[i];
-        dump_tensor<float32_t>(os, latent_seq[i], first_n_elem);
+        auto latent_ptr = latent_parser_ptr_->get_latent(i);
+        if (latent_ptr != nullptr)
+            dump_tensor<float32_t>(os, *latent_ptr, first_n_elem);
+        else
+            os << "[corrupted]";
         os << std::endl;
     }
     os << "CONST_TEXT_EMBEDDING for constant prompt [\"\"] :";
     dump_tensor<float32_t>(os, const_text_embedding, first_n_elem);
-}
\ No newline at end of file
+}
+
+TsEmbeddingCache::TsEmbeddingCache(std::shared_ptr<const DataLoader> loader, const TensorEncoding& encoding,
+    size_t element_count)
+    :loader_(std::move(loader)), codec_(encoding, CpuFeatures::detectIsa()), element_count_(element_count),
+    bank_clock_(0)
+{
+
+}
+
+bool TsEmbeddingCache::computes_ts_embeddings() const
+{
+    return element_count_ != TS_EMBEDDING_ELEMENT_COUNT || loader_->has_time_embedding_mlp();
+}
+
+bool TsEmbeddingCache::get_ts_embedding_by_time_step(int32_t time_step,
+    const tensor_view_float32_t*& t4_ts_embedding_ptr)
+{
+    if (find_precomputed_ts_embedding(time_step, t4_ts_embedding_ptr))
+        return true;
+
+    auto computed_it = computed_ts_embeddings_.find(time_step);
+    if (computed_it == computed_ts_embeddings_.end())
+    {
+        if (!compute_ts_embeddings({ time_step }))
+            return false;
+        computed_it = computed_ts_embeddings_.find(time_step);
+    }
+    t4_ts_embedding_ptr = &computed_it->second.view;
+    return true;
+}
+
+bool TsEmbeddingCache::find_precomputed_ts_embedding(int32_t time_step,
+    const tensor_view_float32_t*& t4_ts_embedding_ptr) const
+{
+    // the precomputed embeddings are the MLP outputs, of no use to a UNet taking the bare projection
+    if (element_count_ != TS_EMBEDDING_ELEMENT_COUNT)
+        return false;
+    return loader_->get_ts_embedding_by_time_step(time_step, t4_ts_embedding_ptr);
+}
+
+bool TsEmbeddingCache::compute_ts_embeddings(const std::vector<int32_t>& time_steps)
+{
+    if (!computes_ts_embeddings())
+        return false;
+    std::vector<float32_t> embeddings(time_steps.size() * element_count_);
+    if (!loader_->compute_ts_embeddings(time_steps, element_count_, embeddings.data()))
+        return false;
+    for (size_t n = 0; n < time_steps.size(); n++)
+    {
+        auto& computed = computed_ts_embeddings_[time_steps[n]];
+        auto first = embeddings.begin() + n * element_count_;
+        computed.data.assign(first, first + element_count_);
+        computed.view = tensor_view_float32_t(computed.data);
+        DEMO_DEBUG("computed ts_embedding of time step %d", time_steps[n]);
+    }
+    return true;
+}
+
+bool TsEmbeddingCache::get_encoded_ts_embeddings(const std::vector<int32_t>& time_steps,
+    const std::vector<uint8_t>*& bank_ptr)
+{
+    auto bank_it = encoded_ts_banks_.find(time_steps);
+    if (bank_it != encoded_ts_banks_.end())
+    {
+        bank_it->second.last_use = ++bank_clock_;
+        bank_ptr = &bank_it->second.data;
+        return true;
+    }
+
+    // the missing embeddings of the schedule are evaluated in one batch
+    std::vector<int32_t> missing_steps;
+    for (auto time_step : time_steps)
+    {
+        const tensor_view_float32_t* ts_embedding_ptr = nullptr;
+        if (!find_precomputed_ts_embedding(time_step, ts_embedding_ptr) &&
+            computed_ts_embeddings_.find(time_step) == computed_ts_embeddings_.end() &&
+            std::find(missing_steps.begin(), missing_steps.end(), time_step) == missing_steps.end())
+        {
+            missing_steps.push_back(time_step);
+        }
+    }
+    if (!missing_steps.empty() && !compute_ts_embeddings(missing_steps))
+        return false;
+
+    std::vector<uint8_t> bank;
+    for (auto time_step : time_steps)
+    {
+        const tensor_view_float32_t* ts_embedding_ptr = nullptr;
+        if (!get_ts_embedding_by_time_step(time_step, ts_embedding_ptr))
+            return false;
+        size_t offset = bank.size();
+        bank.resize(offset + ts_embedding_ptr->size() * codec_.elementSize());
+        codec_.encode(bank.data() + offset, ts_embedding_ptr->data(), ts_embedding_ptr->size());
+    }
+    // keeps the most recently used banks only, a session rarely switches between many schedules
+    if (encoded_ts_banks_.size() >= MAX_ENCODED_TS_BANKS)
+    {
+        auto oldest = encoded_ts_banks_.begin();
+        for (auto it = encoded_ts_banks_.begin(); it != encoded_ts_banks_.end(); ++it)
+        {
+            if (it->second.last_use < oldest->second.last_use)
+                oldest = it;
+        }
+        encoded_ts_banks_.erase(oldest);
+    }
+    auto& entry = encoded_ts_banks_[time_steps];
+    entry.data = std::move(bank);
+    entry.last_use = ++bank_clock_;
+    bank_ptr = &entry.data;
+    return true;
+}
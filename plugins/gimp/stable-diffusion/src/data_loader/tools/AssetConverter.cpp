@@ -0,0 +1,319 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+// Converts the precomputed data tars written by flatten.py into one asset file, see AssetFormat.h
+//
+//  asset_converter [--no_latents] [--time_mlp <SD_1_5|SD_2_1>:<mlp.bin>] <output.sdpk> [<input.tar> ...]
+//
+// --no_latents leaves the precomputed initial latents out, the largest part of the data, for
+// pipelines that generate the latent of a seed.
+// --time_mlp adds the time embedding MLP of the UNet of a model, so that the DataLoader can evaluate
+// the ts embeddings of any number of steps. mlp.bin is the raw float32 concatenation of
+// time_embedding.linear_1.weight, linear_1.bias, linear_2.weight and linear_2.bias, see the README.
+// The model of a tar is told by the size of its constant text embedding, 1x77x768 for SD 1.5 and
+// 1x77x1024 for SD 2.1. Every section read from that tar is tagged with its model, so that the
+// tars of both models can share one asset file.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "AssetFormat.h"
+
+#define TAR_BLOCK_SIZE 512
+#define TS_EMBEDDING_ELEMENT_COUNT (1 * 1280)
+#define TEXT_EMBEDDING_TOKENS 77
+
+struct TarMember {
+    std::string name;
+    const char* data;
+    size_t size;
+};
+
+// A section and the bytes it points to inside its input tar
+struct PendingSection {
+    AssetSection section;
+    const char* data;
+};
+
+static bool endsWith(const std::string& name, const char* ext)
+{
+    const size_t len = strlen(ext);
+    return name.size() >= len && name.compare(name.size() - len, len, ext) == 0;
+}
+
+static int32_t readInt32(const char* data)
+{
+    int32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static bool readTar(const std::string& path, std::vector<char>& content, std::vector<TarMember>& members)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        printf("%s: cannot open\n", path.c_str());
+        return false;
+    }
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    while (pos + TAR_BLOCK_SIZE <= content.size() && content[pos] != 0)
+    {
+        const char* header = content.data() + pos;
+        std::string name(header, strnlen(header, 100));
+        const size_t size = strtoull(std::string(header + 124, 12).c_str(), nullptr, 8);
+        const size_t offset = pos + TAR_BLOCK_SIZE;
+        if (header[156] != '0' || offset + size > content.size())
+        {
+            printf("%s: %s is not a regular file or is truncated\n", path.c_str(), name.c_str());
+            return false;
+        }
+        members.push_back({ name, content.data() + offset, size });
+        pos = offset + (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+    }
+    return true;
+}
+
+static PendingSection makeSection(AssetKind kind, AssetDataType data_type, AssetModel model, int32_t key,
+                                  std::vector<uint32_t> shape, const char* data)
+{
+    PendingSection pending = {};
+    pending.section.kind = uint32_t(kind);
+    pending.section.data_type = uint32_t(data_type);
+    pending.section.model = uint32_t(model);
+    pending.section.key = key;
+    pending.section.rank = uint32_t(shape.size());
+    for (size_t i = 0; i < shape.size(); i++)
+        pending.section.shape[i] = shape[i];
+    pending.section.size = asset_element_count(pending.section) * asset_element_size(pending.section.data_type);
+    pending.data = data;
+    return pending;
+}
+
+// Latents are stored as (1, h, w, 4) when the size allows a square latent, flat otherwise
+static std::vector<uint32_t> latentShape(size_t num_elements)
+{
+    const uint32_t side = (uint32_t)std::lround(std::sqrt(num_elements / 4.0));
+    if ((size_t)side * side * 4 == num_elements)
+        return { 1, side, side, 4 };
+    return { (uint32_t)num_elements };
+}
+
+static bool convertTar(const std::string& path, const std::vector<TarMember>& members, bool with_latents,
+                       std::vector<PendingSection>& sections)
+{
+    AssetModel model = AssetModel::ANY;
+    for (const auto& member : members)
+    {
+        if (!endsWith(member.name, ".cte"))
+            continue;
+        const size_t num_elements = member.size / sizeof(float);
+        if (num_elements == TEXT_EMBEDDING_TOKENS * 768)
+            model = AssetModel::SD_1_5;
+        else if (num_elements == TEXT_EMBEDDING_TOKENS * 1024)
+            model = AssetModel::SD_2_1;
+        else
+        {
+            printf("%s: %s holds %zu floats, not a text embedding of SD 1.5 or 2.1\n", path.c_str(),
+                   member.name.c_str(), num_elements);
+            return false;
+        }
+        sections.push_back(makeSection(AssetKind::CONST_TEXT_EMBEDDING, AssetDataType::FLOAT32, model, 0,
+                                       { 1, TEXT_EMBEDDING_TOKENS, (uint32_t)(num_elements / TEXT_EMBEDDING_TOKENS) },
+                                       member.data));
+    }
+    if (model == AssetModel::ANY)
+        printf("%s: no constant text embedding, its sections are shared by every model\n", path.c_str());
+
+    for (const auto& member : members)
+    {
+        const int32_t count = member.size >= sizeof(int32_t) ? readInt32(member.data) : 0;
+        if (endsWith(member.name, ".rand"))
+        {
+            if (!with_latents)
+                continue;
+            const size_t table_size = sizeof(int32_t) * (1 + (size_t)std::max(count, 0));
+            if (count <= 0 || member.size <= table_size || (member.size - table_size) % (sizeof(float) * count) != 0)
+            {
+                printf("%s: %s has a size of %zu bytes, invalid for %d latents\n", path.c_str(),
+                       member.name.c_str(), member.size, count);
+                return false;
+            }
+            const size_t latent_size = (member.size - table_size) / count;
+            for (int32_t i = 0; i < count; i++)
+            {
+                const int32_t seed = readInt32(member.data + sizeof(int32_t) * (1 + i));
+                sections.push_back(makeSection(AssetKind::LATENT, AssetDataType::FLOAT32, model, seed,
+                                               latentShape(latent_size / sizeof(float)),
+                                               member.data + table_size + latent_size * i));
+            }
+        }
+        else if (endsWith(member.name, ".ts"))
+        {
+            const size_t expected = sizeof(int32_t) * (1 + (size_t)std::max(count, 0)) +
+                                    sizeof(float) * TS_EMBEDDING_ELEMENT_COUNT * std::max(count, 0);
+            if (count <= 0 || member.size != expected)
+            {
+                printf("%s: %s has a size of %zu bytes, expected %zu\n", path.c_str(), member.name.c_str(),
+                       member.size, expected);
+                return false;
+            }
+            sections.push_back(makeSection(AssetKind::TIME_STEPS, AssetDataType::INT32, model, count,
+                                           { (uint32_t)count }, member.data + sizeof(int32_t)));
+            sections.push_back(makeSection(AssetKind::TS_EMBEDDING, AssetDataType::FLOAT32, model, count,
+                                           { (uint32_t)count, TS_EMBEDDING_ELEMENT_COUNT },
+                                           member.data + sizeof(int32_t) * (1 + count)));
+        }
+        else if (!endsWith(member.name, ".cte") && !endsWith(member.name, ".txt"))
+        {
+            printf("%s: skipping %s\n", path.c_str(), member.name.c_str());
+        }
+    }
+    return true;
+}
+
+// The sections of one --time_mlp argument, linear_1 maps the projection channels to 1280 and
+// linear_2 keeps 1280
+static bool convertTimeMlp(const std::string& argument, std::vector<char>& content,
+                           std::vector<PendingSection>& sections)
+{
+    const size_t colon = argument.find(':');
+    const std::string model_name = argument.substr(0, colon);
+    AssetModel model = AssetModel::ANY;
+    if (model_name == "SD_1_5")
+        model = AssetModel::SD_1_5;
+    else if (model_name == "SD_2_1")
+        model = AssetModel::SD_2_1;
+    if (colon == std::string::npos || model == AssetModel::ANY)
+    {
+        printf("%s: expected SD_1_5:<file> or SD_2_1:<file>\n", argument.c_str());
+        return false;
+    }
+    const std::string path = argument.substr(colon + 1);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        printf("%s: cannot open\n", path.c_str());
+        return false;
+    }
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    const size_t hidden = TS_EMBEDDING_ELEMENT_COUNT;
+    const size_t fixed = hidden + hidden * hidden + hidden;
+    const size_t num_elements = content.size() / sizeof(float);
+    const size_t in_channels = num_elements > fixed ? (num_elements - fixed) / hidden : 0;
+    if (content.size() % sizeof(float) != 0 || in_channels == 0 || in_channels * hidden + fixed != num_elements)
+    {
+        printf("%s: %zu bytes, not a time embedding MLP with %zu hidden channels\n", path.c_str(),
+               content.size(), hidden);
+        return false;
+    }
+    const char* data = content.data();
+    sections.push_back(makeSection(AssetKind::TIME_MLP_WEIGHT, AssetDataType::FLOAT32, model, 1,
+                                   { (uint32_t)hidden, (uint32_t)in_channels }, data));
+    data += sizeof(float) * hidden * in_channels;
+    sections.push_back(makeSection(AssetKind::TIME_MLP_BIAS, AssetDataType::FLOAT32, model, 1,
+                                   { (uint32_t)hidden }, data));
+    data += sizeof(float) * hidden;
+    sections.push_back(makeSection(AssetKind::TIME_MLP_WEIGHT, AssetDataType::FLOAT32, model, 2,
+                                   { (uint32_t)hidden, (uint32_t)hidden }, data));
+    data += sizeof(float) * hidden * hidden;
+    sections.push_back(makeSection(AssetKind::TIME_MLP_BIAS, AssetDataType::FLOAT32, model, 2,
+                                   { (uint32_t)hidden }, data));
+    printf("%s: time embedding MLP of %s, %zu -> %zu -> %zu\n", path.c_str(), model_name.c_str(), in_channels,
+           hidden, hidden);
+    return true;
+}
+
+static size_t alignUp(size_t value)
+{
+    return (value + ASSET_SECTION_ALIGNMENT - 1) / ASSET_SECTION_ALIGNMENT * ASSET_SECTION_ALIGNMENT;
+}
+
+static bool writeAsset(const std::string& path, std::vector<PendingSection>& sections)
+{
+    std::vector<char> content(alignUp(sizeof(AssetFileHeader)), 0);
+    std::vector<AssetSection> toc;
+    for (auto& pending : sections)
+    {
+        AssetSection section = pending.section;
+        section.offset = content.size();
+        section.crc32 = asset_crc32(pending.data, section.size);
+        content.insert(content.end(), pending.data, pending.data + section.size);
+        content.resize(alignUp(content.size()), 0);
+        toc.push_back(section);
+    }
+
+    AssetFileHeader header = {};
+    header.magic = ASSET_FILE_MAGIC;
+    header.version = ASSET_FILE_VERSION;
+    header.section_count = (uint32_t)toc.size();
+    header.toc_offset = content.size();
+    header.toc_crc32 = asset_crc32(toc.data(), toc.size() * sizeof(AssetSection));
+    const char* toc_data = reinterpret_cast<const char*>(toc.data());
+    content.insert(content.end(), toc_data, toc_data + toc.size() * sizeof(AssetSection));
+    header.file_size = content.size();
+    memcpy(content.data(), &header, sizeof(header));
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(content.data(), content.size());
+    if (!file.good())
+    {
+        printf("%s: write failed\n", path.c_str());
+        return false;
+    }
+    printf("%s: %zu sections, %zu bytes\n", path.c_str(), toc.size(), content.size());
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    bool with_latents = true;
+    std::vector<std::string> time_mlps;
+    int first = 1;
+    while (first < argc)
+    {
+        if (0 == strcmp(argv[first], "--no_latents"))
+            with_latents = false;
+        else if (0 == strcmp(argv[first], "--time_mlp") && first + 1 < argc)
+            time_mlps.push_back(argv[++first]);
+        else
+            break;
+        first++;
+    }
+    if (argc - first < 1 || (argc - first < 2 && time_mlps.empty()))
+    {
+        printf("usage: %s [--no_latents] [--time_mlp <SD_1_5|SD_2_1>:<mlp.bin>] <output%s> [<input.tar> ...]\n",
+               argv[0], ASSET_FILE_EXT);
+        return 1;
+    }
+
+    // The sections point into the input contents until the asset file is written
+    std::vector<std::vector<char>> contents(argc - first - 1 + time_mlps.size());
+    std::vector<PendingSection> sections;
+    for (size_t i = 0; i < time_mlps.size(); i++)
+    {
+        if (!convertTimeMlp(time_mlps[i], contents[argc - first - 1 + i], sections))
+            return 1;
+    }
+    for (int i = first + 1; i < argc; i++)
+    {
+        std::vector<TarMember> members;
+        if (!readTar(argv[i], contents[i - first - 1], members) ||
+            !convertTar(argv[i], members, with_latents, sections))
+        {
+            return 1;
+        }
+    }
+    return writeAsset(argv[first], sections) ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#ifndef _CPUFEATURES_HPP_
+#define _CPUFEATURES_HPP_
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CPU_FEATURES_X86_64 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define CPU_FEATURES_ARM64 1
+#endif
+
+// Small header-only helper to pick the widest SIMD instruction set the
+// running CPU supports. Kernel libraries compile one variant per ISA and
+// use this at construction time to select their dispatch table.
+class CpuFeatures {
+public:
+    enum class Isa {
+        SCALAR = 0,
+        NEON,
+        AVX2,
+        AVX512
+    };
+
+    static Isa detectIsa()
+    {
+#if defined(CPU_FEATURES_ARM64)
+        // Advanced SIMD is mandatory on AArch64
+        return Isa::NEON;
+#elif defined(CPU_FEATURES_X86_64)
+#if defined(_MSC_VER) && !defined(__clang__)
+        int regs[4];
+        __cpuid(regs, 0);
+        if (regs[0] < 7)
+            return Isa::SCALAR;
+
+        __cpuid(regs, 1);
+        const bool osxsave = (regs[2] & (1 << 27)) != 0;
+        const bool fma = (regs[2] & (1 << 12)) != 0;
+        if (!osxsave)
+            return Isa::SCALAR;
+
+        const unsigned long long xcr0 = _xgetbv(0);
+        const bool ymmState = (xcr0 & 0x6) == 0x6;
+        const bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+        __cpuidex(regs, 7, 0);
+        const bool avx2 = (regs[1] & (1 << 5)) != 0;
+        const bool avx512f = (regs[1] & (1 << 16)) != 0;
+
+        if (avx512f && fma && zmmState)
+            return Isa::AVX512;
+        if (avx2 && fma && ymmState)
+            return Isa::AVX2;
+        return Isa::SCALAR;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma"))
+            return Isa::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return Isa::AVX2;
+        return Isa::SCALAR;
+#endif
+#else
+        return Isa::SCALAR;
+#endif
+    }
+
+    static const char* isaName(Isa isa)
+    {
+        switch (isa)
+        {
+        case Isa::NEON:   return "NEON";
+        case Isa::AVX2:   return "AVX2";
+        case Isa::AVX512: return "AVX-512";
+        default:          return "scalar";
+        }
+    }
+};
+
+#endif
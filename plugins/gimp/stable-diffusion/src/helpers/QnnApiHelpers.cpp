@@ -8,7 +8,9 @@
 
 #include "QnnApiHelpers.hpp"
 
-#define SEED_LENGTH 10
+#include <cmath>
+
+#define SEED_LENGTH 20
 #define STEP_LENGTH 10
 #define GUIDANCE_LENGTH 10
 
@@ -27,6 +29,7 @@ QnnApiHelpers::~QnnApiHelpers()
     // Free Qnn Tensor and their memory
     QNN_DEBUG("Tearing Down Input Tensors Bank");
     m_ioTensor->tearDownTensors(m_InputTensorsBank, m_numInputTensorsMap);
+    tearDownUncondUnetBanks();
     QNN_DEBUG("Tearing Down Output Tensors Bank");
     m_ioTensor->tearDownTensors(m_OutputTensorsBank, m_numOutputTensorsMap);
 
@@ -34,12 +37,32 @@ QnnApiHelpers::~QnnApiHelpers()
     // Make entry of tensors whose memory was released by QNN backend in m_FreeTensorsPointerSet
     for (const auto &freeTensorPointer : m_ioTensor->getFreeTensorsPointerSet())
         m_FreeTensorsPointerSet.insert(freeTensorPointer);
+}
 
-    // Destructor of OffTarget Data Loader
-    delete m_offTargetDataLoader;
-
-    // Destructor of Scheduler Solver
-    delete m_schedulerSolver;
+void QnnApiHelpers::tearDownUncondUnetBanks()
+{
+    if (false == m_UncondUnetInputsBank.empty())
+    {
+        QNN_DEBUG("Tearing Down Unconditional Unet Input Tensors Bank");
+        m_ioTensor->tearDownTensors(m_UncondUnetInputsBank, m_numInputTensorsMap[m_modelsExecOrder[UNET_MODEL_IDX]]);
+    }
+    if (false == m_UncondUnetOutputsBank.empty())
+    {
+        QNN_DEBUG("Tearing Down Unconditional Unet Output Tensors Bank");
+        m_ioTensor->tearDownTensors(m_UncondUnetOutputsBank, m_numOutputTensorsMap[m_modelsExecOrder[UNET_MODEL_IDX]]);
+    }
+    for (const auto &bufBank : {&m_UncondUnetInputsBufBank, &m_UncondUnetOutputsBufBank})
+    {
+        for (const auto &tensorNamePointers : *bufBank)
+        {
+            for (const auto &tensorNamePointer : tensorNamePointers)
+                m_qnnTensorMemorySet.erase(tensorNamePointer.second);
+        }
+    }
+    m_UncondUnetInputsBank.clear();
+    m_UncondUnetInputsBufBank.clear();
+    m_UncondUnetOutputsBank.clear();
+    m_UncondUnetOutputsBufBank.clear();
 }
 
 int32_t QnnApiHelpers::parseConfigPath(std::string configFilePath)
@@ -235,9 +258,93 @@ int32_t QnnApiHelpers::parseConfigPath(std::string configFilePath)
         m_dataLoaderInputTarfile = Helpers::makePathAbsolute(m_DemoDataFolder, kvpMap["data_loader_input_tarfile"]);
     }
 
+    m_SchedulerType = "dpmsolver++";
+    if (kvpMap.find("scheduler_type") != kvpMap.end())
+    {
+        m_SchedulerType = kvpMap["scheduler_type"];
+    }
+
+    m_TimestepSpacing = "";
+    if (kvpMap.find("timestep_spacing") != kvpMap.end())
+    {
+        m_TimestepSpacing = kvpMap["timestep_spacing"];
+    }
+
+    m_AdaptiveTolerance = 0.0f;
+    if (kvpMap.find("adaptive_tolerance") != kvpMap.end())
+    {
+        try
+        {
+            m_AdaptiveTolerance = std::stof(kvpMap["adaptive_tolerance"]);
+        }
+        catch (const std::exception &)
+        {
+            m_AdaptiveTolerance = -1.0f;
+        }
+        if (!std::isfinite(m_AdaptiveTolerance) || m_AdaptiveTolerance < 0.0f)
+        {
+            QNN_ERROR("Invalid adaptive_tolerance %s, expected a finite value >= 0",
+                      kvpMap["adaptive_tolerance"].c_str());
+            return -1;
+        }
+    }
+
+    m_LatentSource = "generated";
+    if (kvpMap.find("latent_source") != kvpMap.end())
+    {
+        m_LatentSource = kvpMap["latent_source"];
+    }
+    if (m_LatentSource != "generated" && m_LatentSource != "precomputed")
+    {
+        QNN_ERROR("Unknown latent_source %s, expected generated or precomputed", m_LatentSource.c_str());
+        return -1;
+    }
+
     return 0;
 }
 
+// Reads the trained betas and lambdas of the data folder and builds the scheduler of the config, runs
+// during the context creation of Init so it only takes copies of the config values
+static std::unique_ptr<Scheduler> createSchedulerFromData(const std::string &demoDataFolder,
+                                                          const std::string &schedulerType,
+                                                          const std::string &timestepSpacing,
+                                                          float32_t adaptiveTolerance)
+{
+    int64_t num_train_timsteps = 1000;
+    std::vector<float32_t> betas(num_train_timsteps);
+    std::string betas_file = Helpers::joinPath(demoDataFolder, "betas.bin");
+    if (true != Helpers::readRawData((void *)betas.data(), betas.size() * sizeof(betas[0]), betas_file))
+    {
+        QNN_ERROR("Error in loading file %s!", betas_file.c_str());
+        return nullptr;
+    }
+
+    std::vector<float32_t> lambdas(num_train_timsteps);
+    std::string lambdas_file = Helpers::joinPath(demoDataFolder, "lambdas.bin");
+    if (true != Helpers::readRawData((void *)lambdas.data(), lambdas.size() * sizeof(lambdas[0]), lambdas_file))
+    {
+        QNN_ERROR("Error in loading file %s!", lambdas_file.c_str());
+        return nullptr;
+    }
+
+    std::unique_ptr<Scheduler> scheduler(
+        createScheduler(schedulerType, /*num_train_timsteps=*/num_train_timsteps, /*beta_start=*/0.00085,
+                        /*beta_end=*/0.012, /*beta_schedule=*/"scaled_linear",
+                        /*trained_betas=*/betas, /*trained_lambdas=*/lambdas));
+    if (nullptr == scheduler)
+    {
+        QNN_ERROR("Error in creating the %s scheduler!", schedulerType.c_str());
+        return nullptr;
+    }
+    if (!timestepSpacing.empty() && true != scheduler->setTimestepSpacing(timestepSpacing))
+    {
+        QNN_ERROR("Error in setting the %s timestep spacing on the scheduler!", timestepSpacing.c_str());
+        return nullptr;
+    }
+    scheduler->setAdaptiveTolerance(adaptiveTolerance);
+    return scheduler;
+}
+
 int32_t QnnApiHelpers::Init(
     std::string configFilePath, std::string nativeLibPath,
     int32_t inputWidth, int32_t inputHeight, float inputChannel,
@@ -275,6 +382,37 @@ int32_t QnnApiHelpers::Init(
     QNN_DEBUG("inputHeight = %d, inputWidth = %d, inputChannel = %f", inputHeight, inputWidth, inputChannel);
     QNN_DEBUG("outputHeight = %d, outputWidth = %d, outputChannel = %f", outputHeight, outputWidth, outputChannel);
 
+    // The tokenizer, the data loader and the scheduler only need the config, they are set up on their
+    // own threads while QNN creates the contexts. Each task works on copies of the config values and
+    // hands its result back through its future, Init waits for the data loader and the scheduler
+    // before using them and PreProcessInput waits for the tokenizer
+    m_TokenizerReady = std::async(std::launch::async, [demoDataFolder = m_DemoDataFolder]()
+    {
+        auto start = std::chrono::steady_clock::now();
+        set_datapath(demoDataFolder.c_str());
+        auto stop = std::chrono::steady_clock::now();
+        Helpers::logProfile("tokenizer warm-up (cpp) took", start, stop);
+    });
+    // The latent size isn't known before the contexts, the loader takes it from the file and it is
+    // checked against the Unet latent input afterwards
+    std::future<std::shared_ptr<DataLoader>> dataLoaderReady = std::async(std::launch::async,
+        [tarFile = m_dataLoaderInputTarfile, model_version]() -> std::shared_ptr<DataLoader>
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::shared_ptr<DataLoader> dataLoader = std::make_shared<DataLoader>();
+        if (false == dataLoader->load((char *)tarFile.c_str(), model_version, 0))
+            return nullptr;
+        auto stop = std::chrono::steady_clock::now();
+        Helpers::logProfile("loading data loader file (cpp) took", start, stop);
+        return dataLoader;
+    });
+    std::future<std::unique_ptr<Scheduler>> schedulerReady = std::async(std::launch::async,
+        [demoDataFolder = m_DemoDataFolder, schedulerType = m_SchedulerType, timestepSpacing = m_TimestepSpacing,
+         adaptiveTolerance = m_AdaptiveTolerance]() -> std::unique_ptr<Scheduler>
+    {
+        return createSchedulerFromData(demoDataFolder, schedulerType, timestepSpacing, adaptiveTolerance);
+    });
+
     // Create and initialize Qnn APIs
     m_qnnApi = std::unique_ptr<QnnApi>(new QnnApi());
 
@@ -497,6 +635,26 @@ int32_t QnnApiHelpers::Init(
         }
     }
 
+    // The conditional Unet pass reads the Text Encoder output in place: connect it to the Unet text embedding
+    // input, unless the config already does. The unconditional pass has its own text embedding input.
+    // The Unet input keeps the memory, the buffer managers record the Text Encoder outputs as its aliases
+    // and free it once, through the Unet input bank
+    {
+        const std::pair<std::string, std::string> textEncoderOutputName = {
+            m_modelsExecOrder[TEXT_ENCODER_MODEL_IDX],
+            m_ModelOutputImageDims[m_modelsExecOrder[TEXT_ENCODER_MODEL_IDX]].begin()->first};
+        bool connected = false;
+        for (const auto &connectedIpOpTensor : m_connectedIpOpTensorPairs)
+        {
+            if (connectedIpOpTensor[0] == m_InputTensorName && connectedIpOpTensor[1] == textEncoderOutputName)
+                connected = true;
+        }
+        if (false == connected)
+        {
+            m_connectedIpOpTensorPairs.push_back({m_InputTensorName, textEncoderOutputName});
+        }
+    }
+
     // Checking if the tensors name provided in m_connectedIpOpTensorPairs are present
     for (const auto &connectedIpOpTensor : m_connectedIpOpTensorPairs)
     {
@@ -679,11 +837,80 @@ int32_t QnnApiHelpers::Init(
         std::memset(m_ioTensor->getBuffer(src), 0, m_ioTensor->getBufferSize(src));
     }
 
-    // Define memory for m_PredBatchNoise to hold Pred. batch noise data
+    // Create the Unet input tensors of the unconditional pass for each input bank. All but the text embedding
+    // use the memory of the bank tensors, so only the constant text embedding differs between the two passes
     {
-        // Pred. batch noise needs to hold the output of 2 Unet runs
-        const auto &dim = m_ModelOutputImageDims[m_modelsExecOrder[UNET_MODEL_IDX]].begin()->second;
-        m_PredBatchNoise = std::vector<float32_t>(2 * dim.height * dim.width * dim.channel);
+        const auto &unetGraphName = m_modelsExecOrder[UNET_MODEL_IDX];
+        GraphInfo_t *unetGraphInfo = nullptr;
+        for (size_t graphIdx = 0; graphIdx < graphsCount; graphIdx++)
+        {
+            if (unetGraphName == graphsInfo[graphIdx]->graphName)
+                unetGraphInfo = graphsInfo[graphIdx];
+        }
+        if (nullptr == unetGraphInfo)
+        {
+            QNN_ERROR("Graph %s of Unet not found", unetGraphName.c_str());
+            return -1;
+        }
+
+        std::unordered_map<std::string, size_t> inputTensorsSize;
+        for (const auto &tensorNameShape : m_ModelInputImageDims[unetGraphName])
+        {
+            inputTensorsSize[tensorNameShape.first] = tensorNameShape.second.getImageSize();
+        }
+        for (uint8_t idx = 0; idx < m_preProcessBankSize; idx++)
+        {
+            Qnn_Tensor_t *inputs = nullptr;
+            std::unordered_map<std::string, void *> tensorNameToTensorPointer;
+            if (true != m_ioTensor->setupInputTensors(&inputs, tensorNameToTensorPointer, *unetGraphInfo, inputTensorsSize))
+            {
+                QNN_ERROR("Error in setting up unconditional Unet Input Tensors for bank idx: %d", idx);
+                tearDownUncondUnetBanks();
+                return -1;
+            }
+            m_UncondUnetInputsBank.push_back(inputs);
+            m_UncondUnetInputsBufBank.push_back(tensorNameToTensorPointer);
+            for (const auto &tensorNamePointer : tensorNameToTensorPointer)
+            {
+                m_qnnTensorMemorySet.insert(tensorNamePointer.second);
+                if (tensorNamePointer.first == m_InputTensorName.second)
+                    continue;
+                if (false == m_ioTensor->useSameMemory(
+                                 (Qnn_Tensor_t *)tensorNamePointer.second,
+                                 (Qnn_Tensor_t *)m_InputTensorsBufBank[idx][unetGraphName][tensorNamePointer.first]))
+                {
+                    QNN_ERROR("Error in sharing the memory of Unet input tensor %s with the unconditional pass",
+                              tensorNamePointer.first.c_str());
+                    tearDownUncondUnetBanks();
+                    return -1;
+                }
+            }
+        }
+
+        // The unconditional pass writes its own output memory, so the scheduler reads both quantized
+        // predictions straight from the Unet outputs
+        std::unordered_map<std::string, size_t> outputTensorsSize;
+        for (const auto &tensorNameShape : m_ModelOutputImageDims[unetGraphName])
+        {
+            outputTensorsSize[tensorNameShape.first] = tensorNameShape.second.getImageSize();
+        }
+        for (uint8_t idx = 0; idx < m_postProcessBankSize; idx++)
+        {
+            Qnn_Tensor_t *outputs = nullptr;
+            std::unordered_map<std::string, void *> tensorNameToTensorPointer;
+            if (true != m_ioTensor->setupOutputTensors(&outputs, tensorNameToTensorPointer, *unetGraphInfo, outputTensorsSize))
+            {
+                QNN_ERROR("Error in setting up unconditional Unet Output Tensors for bank idx: %d", idx);
+                tearDownUncondUnetBanks();
+                return -1;
+            }
+            m_UncondUnetOutputsBank.push_back(outputs);
+            m_UncondUnetOutputsBufBank.push_back(tensorNameToTensorPointer);
+            for (const auto &tensorNamePointer : tensorNameToTensorPointer)
+            {
+                m_qnnTensorMemorySet.insert(tensorNamePointer.second);
+            }
+        }
     }
 
     // Define memory for m_SchLatent to hold scheduler output
@@ -693,14 +920,6 @@ int32_t QnnApiHelpers::Init(
         m_SchLatent = std::vector<float32_t>(dim.height * dim.width * dim.channel);
     }
 
-    // Define memory for m_ConstTextEmbeddingQuantized to hold quantized data of constant text embedding
-    {
-        // m_ConstTextEmbeddingQuantized holds quantized constant text embedding. Hence its size should be
-        // equal to the size of input to UNET
-        const auto &dim = m_ModelInputImageDims[m_InputTensorName.first][m_InputTensorName.second];
-        m_ConstTextEmbeddingQuantized = std::vector<uint16_t>(dim.height * dim.width * dim.channel);
-    }
-
     // Verification of Text Encoder Quantization
     // 1. input
     {
@@ -779,120 +998,120 @@ int32_t QnnApiHelpers::Init(
         QNN_DEBUG("Dequantization enabled for the output");
     }
 
-    // Reading output quantization parameters of Text Encoder
+    const CpuFeatures::Isa isa = CpuFeatures::detectIsa();
+    QNN_DEBUG("Using %s conversion kernels", CpuFeatures::isaName(isa));
+
+    // Reading the data type and encoding of every tensor converted on the CPU, UFIXED16 tensors take
+    // the SIMD paths and the other types go through their TensorCodec conversion
+    // 1. Text Encoder output
     {
         const auto &tensor = (Qnn_Tensor_t *)m_OutputTensorsBufBank[0][m_modelsExecOrder[TEXT_ENCODER_MODEL_IDX]].begin()->second;
-        if (m_qnnApi->getTensorQuantStatus(tensor, m_TeOutQuantParam.scale, m_TeOutQuantParam.offset))
-        {
-            m_TeOutQuantParam.active = true;
-        }
-        if (false == m_TeOutQuantParam.active)
-        {
-            QNN_ERROR("The output qunatization of Text Encoder is supposed to be enable, found it disabled!");
+        if (true != readTensorCodec(tensor, "Text Encoder output", isa, m_TeOutCodec))
             return -1;
-        }
     }
-
-    // Reading Embedding input quantization parameters of Unet
-    {
-        // Unet emebdding input is same as app main input
-        m_UnetInQuantParam = inputQuantParam;
-        if (false == m_UnetInQuantParam.active)
-        {
-            QNN_ERROR("The Embedding input qunatization of Unet is supposed to be enable, found it disabled!");
-            return -1;
+    // 2. Unet embedding input, same as app main input
+    if (true != readTensorCodec(input_tensor, "Unet text embedding input", isa, m_UnetInCodec))
+        return -1;
+    // Building the requantization table from Text Encoder output to Unet embedding input. The Unet
+    // reads the Text Encoder output memory, the dims check above made sure both elements have the
+    // same size, so every other pair of encodings is converted in place by m_UnetInCodec
+    m_TeToUnetRequantLut.clear();
+    if (m_TeOutCodec.getType() == TensorDataType::UFIXED16 && m_UnetInCodec.getType() == TensorDataType::UFIXED16 &&
+        m_TeOutCodec.getEncoding() != m_UnetInCodec.getEncoding())
+    {
+        const auto &teOut = m_TeOutCodec.getEncoding();
+        const auto &unetIn = m_UnetInCodec.getEncoding();
+        m_TeToUnetRequantLut = std::vector<uint16_t>(65536);
+        for (uint32_t quantized = 0; quantized < 65536; quantized++)
+        {
+            double value = ((double)quantized + teOut.offset) * teOut.scale;
+            value = value / unetIn.scale - unetIn.offset;
+            value = value < 0.0 ? 0.0 : value > 65535.0 ? 65535.0
+                                                        : value;
+            m_TeToUnetRequantLut[quantized] = (uint16_t)value;
         }
     }
-    // Reading Latent input quantization parameters of Unet
+    // 3. Unet latent input
     {
         const auto &tensor = (Qnn_Tensor_t *)m_InputTensorsBufBank[0][m_LatentTensorName.first][m_LatentTensorName.second];
-        if (m_qnnApi->getTensorQuantStatus(tensor, m_LatentQuantParam.scale, m_LatentQuantParam.offset))
-        {
-            m_LatentQuantParam.active = true;
-        }
-        if (false == m_LatentQuantParam.active)
-        {
-            QNN_ERROR("The Latent input qunatization of Unet is supposed to be enable, found it disabled!");
+        if (true != readTensorCodec(tensor, "Unet latent input", isa, m_LatentCodec))
             return -1;
-        }
     }
-    // Reading Ts Embedding input quantization parameters of Unet
+    // 4. Unet Ts embedding input
     {
         const auto &tensor = (Qnn_Tensor_t *)m_InputTensorsBufBank[0][m_TsEmbedTensorName.first][m_TsEmbedTensorName.second];
-        if (m_qnnApi->getTensorQuantStatus(tensor, m_TsEmbedQuantParam.scale, m_TsEmbedQuantParam.offset))
-        {
-            m_TsEmbedQuantParam.active = true;
-        }
-        if (false == m_TsEmbedQuantParam.active)
-        {
-            QNN_ERROR("The Ts Embedding input qunatization of Unet is supposed to be enable, found it disabled!");
+        if (true != readTensorCodec(tensor, "Unet Ts embedding input", isa, m_TsEmbedCodec))
             return -1;
-        }
     }
-    // Reading output quantization parameters of Unet
+    // 5. Unet output
     {
         const auto &tensor = (Qnn_Tensor_t *)m_OutputTensorsBufBank[0][m_modelsExecOrder[UNET_MODEL_IDX]].begin()->second;
-        if (m_qnnApi->getTensorQuantStatus(tensor, m_UnetOutQuantParam.scale, m_UnetOutQuantParam.offset))
+        if (true != readTensorCodec(tensor, "Unet output", isa, m_UnetOutCodec))
+            return -1;
+        // The scheduler dequantizes UFIXED16 outputs itself, the other types are decoded for it
+        m_UnetOutputs.clear();
+        if (m_UnetOutCodec.getType() != TensorDataType::UFIXED16)
         {
-            m_UnetOutQuantParam.active = true;
+            m_UnetOutputs = std::vector<float32_t>(2 * m_SchLatent.size());
         }
-        if (false == m_UnetOutQuantParam.active)
-        {
-            QNN_ERROR("The output qunatization of Unet is supposed to be enable, found it disabled!");
+    }
+    // 6. VAE input
+    {
+        const auto &tensor = (Qnn_Tensor_t *)m_InputTensorsBufBank[0][m_modelsExecOrder[VAE_MODEL_IDX]].begin()->second;
+        if (true != readTensorCodec(tensor, "VAE input", isa, m_VaeInCodec))
             return -1;
-        }
     }
 
-    // Reading input quantization parameters of VAE
+    // Now, since all buffers and quantization/dequantization info is available, lets call
+    // OffTarget Data loader setup processes
+    // Latent shape of Unet drives the sizes used by the data loader and the scheduler
+    const auto &latentDims = m_ModelInputImageDims[m_LatentTensorName.first][m_LatentTensorName.second];
     {
-        const auto &tensor = (Qnn_Tensor_t *)m_InputTensorsBufBank[0][m_modelsExecOrder[VAE_MODEL_IDX]].begin()->second;
-        if (m_qnnApi->getTensorQuantStatus(tensor, m_VaeInQuantParam.scale, m_VaeInQuantParam.offset))
+        std::shared_ptr<DataLoader> dataLoader = dataLoaderReady.get();
+        if (nullptr == dataLoader)
         {
-            m_VaeInQuantParam.active = true;
+            QNN_ERROR("Error in running load on m_offTargetDataLoader!");
+            return -1;
         }
-        if (false == m_VaeInQuantParam.active)
+        if (dataLoader->get_num_initial_latents() > 0 && dataLoader->get_latent_element_count() != m_SchLatent.size())
         {
-            QNN_ERROR("The input qunatization of VAE is supposed to be enable, found it disabled!");
+            QNN_ERROR("The precomputed latents have %zu elements, the Unet latent input %zu",
+                      dataLoader->get_latent_element_count(), m_SchLatent.size());
             return -1;
         }
+        m_offTargetDataLoader = dataLoader;
     }
 
-    // Now, since all buffers and quantization/dequantization info is available, lets call
-    // OffTarget Data loader setup processes
-    m_offTargetDataLoader = new DataLoader;
-    if (false == m_offTargetDataLoader->load((char *)m_dataLoaderInputTarfile.c_str(), model_version))
+    // A Unet with the time embedding MLP inside takes the bare sinusoidal projection, of another size
     {
-        QNN_ERROR("Error in running load on m_offTargetDataLoader!");
-        return -1;
+        const auto &tsEmbedDims = m_ModelInputImageDims[m_TsEmbedTensorName.first][m_TsEmbedTensorName.second];
+        m_TsEmbeddingCache.reset(new TsEmbeddingCache(m_offTargetDataLoader, m_TsEmbedCodec.getEncoding(),
+                                                       (size_t)(tsEmbedDims.height * tsEmbedDims.width * tsEmbedDims.channel)));
     }
 
-    // Now, since all buffers and quantization/dequantization info is available, lets call
-    // Scheduler setup processes
-    int64_t num_train_timsteps = 1000;
-    std::vector<float32_t> betas(num_train_timsteps);
-    std::string betas_file = Helpers::joinPath(m_DemoDataFolder, "betas.bin");
-    if (true != Helpers::readRawData((void *)betas.data(), betas.size() * sizeof(betas[0]), betas_file))
+    // The constant text embedding of the unconditional Unet pass never changes, quantize it once
     {
-        QNN_ERROR("Error in loading file %s!", betas_file.c_str());
-        return -1;
+        auto start = std::chrono::steady_clock::now();
+        const tensor_view_float32_t *const_text_embedding_ptr = nullptr;
+        m_offTargetDataLoader->get_unconditional_text_embedding(const_text_embedding_ptr);
+        if (true != writeConstTextEmbedding(*const_text_embedding_ptr))
+            return -1;
+        auto stop = std::chrono::steady_clock::now();
+        Helpers::logProfile("writing const-embedding input (cpp) took", start, stop);
     }
 
-    std::vector<float32_t> lambdas(num_train_timsteps);
-    std::string lambdas_file = Helpers::joinPath(m_DemoDataFolder, "lambdas.bin");
-    if (true != Helpers::readRawData((void *)lambdas.data(), lambdas.size() * sizeof(lambdas[0]), lambdas_file))
+    // Now, since all buffers and quantization/dequantization info is available, lets finish the
+    // Scheduler setup processes with the latent shape
+    m_schedulerSolver = schedulerReady.get();
+    if (nullptr == m_schedulerSolver)
+        return -1;
+    if (true != m_schedulerSolver->setLatentShape(latentDims.height, latentDims.width, (int32_t)latentDims.channel))
     {
-        QNN_ERROR("Error in loading file %s!", lambdas_file.c_str());
+        QNN_ERROR("Error in setting the latent shape %dx%dx%d on the scheduler!",
+                  latentDims.height, latentDims.width, (int32_t)latentDims.channel);
         return -1;
     }
 
-    m_schedulerSolver = new DPMSolverMultistepScheduler(/*num_train_timsteps=*/num_train_timsteps, /*beta_start=*/0.00085,
-                                                        /*beta_end=*/0.012, /*beta_schedule=*/"scaled_linear",
-                                                        /*trained_betas=*/betas, /*trained_lambdas=*/lambdas);
-
-    // Now, since all buffers and quantization/dequantization info is available, lets call
-    // Tokenizer setup processes
-    set_datapath(m_DemoDataFolder.c_str());
-
     uint32_t imageReadSize = m_InputDims.getImageSize();
 
     // Define few storages to hold original images across stages for overlay, and other info
@@ -961,19 +1180,28 @@ bool QnnApiHelpers::PreProcessInput(
     auto &preprocess_count = m_preprocess_count;
     QNN_DEBUG("%s: START Iteration %d", __FUNCTION__, preprocess_count);
 
+    // The tokenizer warm-up started by Init may still be running at the first prompt
+    if (m_TokenizerReady.valid())
+    {
+        auto start = std::chrono::steady_clock::now();
+        m_TokenizerReady.get();
+        auto stop = std::chrono::steady_clock::now();
+        Helpers::logProfile("waiting for the tokenizer (cpp) took", start, stop);
+    }
+
     // Read user provided text, seed, step and guidance scale values
     // image should encapsulate it as follows:
     //      [0:SEED_LENGTH-1] : seed,
     //      [SEED_LENGTH:SEED_LENGTH+STEP_LENGTH-1] : step,
     //      [SEED_LENGTH+STEP_LENGTH:SEED_LENGTH+STEP_LENGTH+GUIDANCE_LENGTH-1] : guidance scale,
     //      [SEED_LENGTH+STEP_LENGTH+GUIDANCE_LENGTH:imageSize-1] : text
-    int32_t userSeed;
+    int64_t userSeed;
     uint32_t userSteps;
     float guidanceScale;
     std::string userText;
     {
         auto start = std::chrono::steady_clock::now();
-        userSeed = std::stoi(std::string((char *)image, SEED_LENGTH));
+        userSeed = std::stoll(std::string((char *)image, SEED_LENGTH));
         userSteps = std::stoi(std::string((char *)image + SEED_LENGTH, STEP_LENGTH));
         guidanceScale = std::stof(std::string((char *)image + SEED_LENGTH + STEP_LENGTH, GUIDANCE_LENGTH));
         userText = std::string((char *)image + SEED_LENGTH + STEP_LENGTH + GUIDANCE_LENGTH, imageSize - SEED_LENGTH - STEP_LENGTH - GUIDANCE_LENGTH);
@@ -992,42 +1220,68 @@ bool QnnApiHelpers::PreProcessInput(
 #endif
     }
 
-    // Checking the provided step value if it is available in data-loader
-    std::vector<int32_t> available_step_seq;
-    m_offTargetDataLoader->get_supported_num_steps(available_step_seq);
-    bool valid_user_step = false;
-    for (const auto &available_step : available_step_seq)
+    // Setting up user provided time steps for Scheduler
+    if (true != m_schedulerSolver->setTimesteps(userSteps))
     {
-        if (userSteps == available_step)
-        {
-            valid_user_step = true;
-            break;
-        }
+        QNN_ERROR("Failed to build the %s scheduler step plan for %d steps", m_SchedulerType.c_str(), userSteps);
+        return false;
     }
-    if (false == valid_user_step)
+    m_schedulerSolver->setGuidanceScale(guidanceScale);
+    m_schedulerSolver->setNoiseSeed(userSeed);
+
+    // Getting the Ts embeddings of every scheduler time step in the Unet input encoding, the data-loader
+    // converts them on the first use of a schedule
     {
-        QNN_ERROR("Provided user step %d is not available", userSteps);
-        QNN_DEBUG("Available steps are:");
-        for (const auto &available_step : available_step_seq)
+        auto start = std::chrono::steady_clock::now();
+        std::vector<int32_t> time_steps(m_schedulerSolver->getNumInferenceSteps());
+        for (int32_t step_index = 0; step_index < (int32_t)time_steps.size(); step_index++)
         {
-            QNN_DEBUG("%d", available_step);
+            time_steps[step_index] = m_schedulerSolver->getTimestep(step_index);
         }
-        return false;
+        if (true != m_TsEmbeddingCache->get_encoded_ts_embeddings(time_steps, m_EncodedTsEmbeddings))
+        {
+            QNN_ERROR("A time step of the %d step %s schedule has no Ts embedding", userSteps,
+                      m_SchedulerType.c_str());
+            if (m_TsEmbeddingCache->computes_ts_embeddings())
+                return false;
+            QNN_DEBUG("The data loader file holds no time embedding MLP to compute the others");
+            std::vector<int32_t> available_step_seq;
+            m_offTargetDataLoader->get_supported_num_steps(available_step_seq);
+            QNN_DEBUG("Ts embeddings are available for the DPM-Solver++ schedules of steps:");
+            for (const auto &available_step : available_step_seq)
+            {
+                QNN_DEBUG("%d", available_step);
+            }
+            return false;
+        }
+
+        const auto &dim = m_ModelInputImageDims[m_TsEmbedTensorName.first][m_TsEmbedTensorName.second];
+        const size_t ts_embedding_bytes = (size_t)(dim.height * dim.width * dim.channel) * m_TsEmbedCodec.elementSize();
+        if (m_EncodedTsEmbeddings->size() != time_steps.size() * ts_embedding_bytes)
+        {
+            QNN_ERROR("The Ts embedding data size %lu doesn't match with %lu steps of the Ts embedding input of Unet",
+                      m_EncodedTsEmbeddings->size(), time_steps.size());
+            return false;
+        }
+        auto stop = std::chrono::steady_clock::now();
+        Helpers::logProfile("getting encoded Ts embeddings (cpp) took", start, stop);
     }
-    m_offTargetDataLoader->set_num_steps(userSteps);
 
-    // Checking the provided seed value if it is available in data-loader
-    if (userSeed >= m_offTargetDataLoader->get_num_initial_latents())
+    // Generated latents take any seed, precomputed ones are picked by the seed modulo their count so
+    // that the seeds drawn for batches or by the UI work with both sources
+    int64_t latentIndex = userSeed;
+    if ("precomputed" == m_LatentSource)
     {
-        QNN_ERROR("Provided user seed value %d is more than available # of seeds %d",
-                  userSeed, m_offTargetDataLoader->get_num_initial_latents());
-        return false;
+        const int64_t numLatents = m_offTargetDataLoader->get_num_initial_latents();
+        if (numLatents <= 0)
+        {
+            QNN_ERROR("latent_source is precomputed but the data loader has no initial latents");
+            return false;
+        }
+        latentIndex = ((userSeed % numLatents) + numLatents) % numLatents;
+        QNN_DEBUG("Seed %lld picks the precomputed latent %lld", (long long)userSeed, (long long)latentIndex);
     }
 
-    // Setting up user provided time steps for Scheduler
-    m_schedulerSolver->setTimesteps(userSteps);
-    m_schedulerSolver->setGuidanceScale(guidanceScale);
-
     // Call Tokenizer
     {
         auto start = std::chrono::steady_clock::now();
@@ -1101,20 +1355,21 @@ bool QnnApiHelpers::PreProcessInput(
     }
     // Now we will de-quantize the output of Text Encoder and then quantize it for Unet Text embedding input
     // We will use same buffer pointed by Text Encoder output for reading and writing as the input and output
-    // data bitwidth is same
+    // data bitwidth is same. The Unet text embedding input shares this memory, so the denoising steps read
+    // the result without any copy
     {
         auto start = std::chrono::steady_clock::now();
         const auto &tensor = m_OutputTensorsBufBank[m_pre_pingpong_index][m_modelsExecOrder[TEXT_ENCODER_MODEL_IDX]].begin()->second;
-        uint16_t *tensor_buf;
+        void *tensor_buf;
         size_t tensor_buf_len;
         if (0 != m_qnnTensorMemorySet.count(tensor))
         {
-            tensor_buf = (uint16_t *)m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
-            tensor_buf_len = m_ioTensor->getBufferSize((Qnn_Tensor_t *)tensor) / 2;
+            tensor_buf = m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
+            tensor_buf_len = m_ioTensor->getBufferSize((Qnn_Tensor_t *)tensor) / m_TeOutCodec.elementSize();
         }
         else
         {
-            tensor_buf = (uint16_t *)tensor;
+            tensor_buf = tensor;
             tensor_buf_len = 0;
         }
 
@@ -1129,23 +1384,26 @@ bool QnnApiHelpers::PreProcessInput(
         }
 #endif
 
-        // Applying de-qunatization and then quantization on Text Encoder output data
-        for (size_t idx = 0; idx < tensor_buf_len; idx++)
-        {
-            // De-quantization
-            double value = ((double)(*tensor_buf) + m_TeOutQuantParam.offset) * m_TeOutQuantParam.scale;
-
 #ifdef PRELOAD_DATA
-            value = (double)float_text_embedding_T2[idx];
-#endif
-
-            // Quantization
-            value = value / m_UnetInQuantParam.scale - m_UnetInQuantParam.offset;
-            value = value < 0.0 ? 0.0 : value > 65535.0 ? 65535.0
-                                                        : value;
-            *tensor_buf = (uint16_t)value;
-            tensor_buf++;
+        m_UnetInCodec.encode(tensor_buf, float_text_embedding_T2.data(), tensor_buf_len);
+#else
+        // Applying de-qunatization and then quantization on Text Encoder output data through the table
+        // built at Init between two UFIXED16 encodings, other encodings are converted in place and the
+        // data is left untouched when it already uses the Unet encoding
+        if (false == m_TeToUnetRequantLut.empty())
+        {
+            const uint16_t *lut = m_TeToUnetRequantLut.data();
+            uint16_t *quantized = (uint16_t *)tensor_buf;
+            for (size_t idx = 0; idx < tensor_buf_len; idx++)
+            {
+                quantized[idx] = lut[quantized[idx]];
+            }
+        }
+        else
+        {
+            m_UnetInCodec.convertFrom(tensor_buf, tensor_buf, m_TeOutCodec, tensor_buf_len);
         }
+#endif
         auto stop = std::chrono::steady_clock::now();
         Helpers::logProfile("dequantizing-quantizing of Text Encoder output (cpp) took", start, stop);
     }
@@ -1153,90 +1411,103 @@ bool QnnApiHelpers::PreProcessInput(
     // Getting random initial latent data
     {
         auto start = std::chrono::steady_clock::now();
-        const tensor_data_float32_t *latent_ptr = nullptr;
-        int32_t seed;
-        m_offTargetDataLoader->get_random_init_latent(userSeed, seed, latent_ptr);
-
-        if (latent_ptr->size() != m_SchLatent.size())
+        if ("generated" == m_LatentSource)
         {
-            QNN_ERROR("The random latent data size %lu doesn't match with the size %lu of latent input of Unet",
-                      latent_ptr->size(), m_SchLatent.size());
-            return false;
+            // Same latent as torch.randn with a generator seeded with userSeed in the diffusers pipelines
+            const auto &dim = m_ModelInputImageDims[m_LatentTensorName.first][m_LatentTensorName.second];
+            m_LatentGenerator.manualSeed((uint64_t)userSeed);
+            if (true != m_LatentGenerator.randnLatent(m_SchLatent.data(), dim.height, dim.width, (int32_t)dim.channel))
+            {
+                QNN_ERROR("The latent input of Unet is too small for the random latent generator");
+                return false;
+            }
+
+#ifdef DEBUG_DUMP
+            char buffer[20];
+            sprintf(buffer, "%03d", preprocess_count);
+            Helpers::writeRawData((void *)(&userSeed), sizeof(userSeed),
+                                  getDebugFile(Helpers::joinPath("dataloader", std::string(buffer) + "_user_seed_in.raw")));
+            Helpers::writeRawData((void *)m_SchLatent.data(), m_SchLatent.size() * sizeof(m_SchLatent[0]),
+                                  getDebugFile(Helpers::joinPath("dataloader", std::string(buffer) + "_initial_random_latent_out.raw")));
+#endif
         }
-        else if (sizeof((*latent_ptr)[0]) != sizeof(m_SchLatent[0]))
+        else
         {
-            QNN_ERROR("The random latent data type size %lu doesn't match with the data type size %lu of latent input of Unet",
-                      sizeof((*latent_ptr)[0]), sizeof(m_SchLatent[0]));
-            return false;
-        }
+            const tensor_view_float32_t *latent_ptr = nullptr;
+            int32_t seed;
+            if (true != m_offTargetDataLoader->get_random_init_latent((uint32_t)latentIndex, seed, latent_ptr))
+            {
+                QNN_ERROR("Error in reading the precomputed latent %lld", (long long)latentIndex);
+                return false;
+            }
+
+            if (latent_ptr->size() != m_SchLatent.size())
+            {
+                QNN_ERROR("The random latent data size %lu doesn't match with the size %lu of latent input of Unet",
+                          latent_ptr->size(), m_SchLatent.size());
+                return false;
+            }
+            else if (sizeof((*latent_ptr)[0]) != sizeof(m_SchLatent[0]))
+            {
+                QNN_ERROR("The random latent data type size %lu doesn't match with the data type size %lu of latent input of Unet",
+                          sizeof((*latent_ptr)[0]), sizeof(m_SchLatent[0]));
+                return false;
+            }
 
 #ifdef DEBUG_DUMP
-        char buffer[20];
-        sprintf(buffer, "%03d", preprocess_count);
-        Helpers::writeRawData((void *)(&userSeed), sizeof(userSeed),
-                              getDebugFile(Helpers::joinPath("dataloader", std::string(buffer) + "_user_seed_in.raw")));
-        Helpers::writeRawData((void *)(&seed), sizeof(seed),
-                              getDebugFile(Helpers::joinPath("dataloader", std::string(buffer) + "_initial_seed_out.raw")));
-        Helpers::writeRawData((void *)latent_ptr->data(), latent_ptr->size() * sizeof((*latent_ptr)[0]),
-                              getDebugFile(Helpers::joinPath("dataloader", std::string(buffer) + "_initial_random_latent_out.raw")));
+            char buffer[20];
+            sprintf(buffer, "%03d", preprocess_count);
+            Helpers::writeRawData((void *)(&userSeed), sizeof(userSeed),
+                                  getDebugFile(Helpers::joinPath("dataloader", std::string(buffer) + "_user_seed_in.raw")));
+            Helpers::writeRawData((void *)(&seed), sizeof(seed),
+                                  getDebugFile(Helpers::joinPath("dataloader", std::string(buffer) + "_initial_seed_out.raw")));
+            Helpers::writeRawData((void *)latent_ptr->data(), latent_ptr->size() * sizeof((*latent_ptr)[0]),
+                                  getDebugFile(Helpers::joinPath("dataloader", std::string(buffer) + "_initial_random_latent_out.raw")));
 #endif
+
+            // Writing random initial data into scheduler latent output which will be feed to Unet and Scheduler
+            // m_SchLatent will be filled by scheduler for subsequent runs
+            std::memcpy((char *)m_SchLatent.data(), (char *)latent_ptr->data(), latent_ptr->size() * sizeof((*latent_ptr)[0]));
+        }
 #ifdef PRELOAD_DATA
-        if (false == Helpers::readRawData((void *)latent_ptr->data(), latent_ptr->size() * sizeof((*latent_ptr)[0]),
+        // The data loader latents are read-only views into its data file, inject into the copy
+        if (false == Helpers::readRawData((void *)m_SchLatent.data(), m_SchLatent.size() * sizeof(m_SchLatent[0]),
                                           m_DemoDataFolder + "unet/sample_" + m_SampleNum + "/inputs/000_t5_sample.bin"))
         {
             QNN_ERROR("There is an Error in reading the data from file");
             return false;
         }
 #endif
-
-        // Writing random initial data into scheduler latent output which will be feed to Unet and Scheduler
-        // m_SchLatent will be filled by scheduler for subsequent runs
-        std::memcpy((char *)m_SchLatent.data(), (char *)latent_ptr->data(), latent_ptr->size() * sizeof((*latent_ptr)[0]));
+        m_LatentInputReady = false;
+        // Schedulers working in sigma space start from noise of a larger scale
+        const float32_t init_noise_sigma = m_schedulerSolver->getInitNoiseSigma();
+        if (1.0f != init_noise_sigma)
+        {
+            for (auto &value : m_SchLatent)
+            {
+                value *= init_noise_sigma;
+            }
+        }
         auto stop = std::chrono::steady_clock::now();
         Helpers::logProfile("writing random latent (cpp) took", start, stop);
     }
 
-    // Getting const embedding from data-loader for every 1st Unet run
-    {
-        auto start = std::chrono::steady_clock::now();
-        const tensor_data_float32_t *const_text_embedding_ptr = nullptr;
-        m_offTargetDataLoader->get_unconditional_text_embedding(const_text_embedding_ptr);
-
-        if (const_text_embedding_ptr->size() != m_ConstTextEmbeddingQuantized.size())
-        {
-            QNN_ERROR("The const embedding data size %lu doesn't match with the size %lu of embedding input of Unet",
-                      const_text_embedding_ptr->size(), m_ConstTextEmbeddingQuantized.size());
-            return false;
-        }
-
-#ifdef DEBUG_DUMP
-        char buffer[20];
-        sprintf(buffer, "%03d", preprocess_count);
-        Helpers::writeRawData((void *)const_text_embedding_ptr->data(), const_text_embedding_ptr->size() * sizeof((*const_text_embedding_ptr)[0]),
-                              getDebugFile(Helpers::joinPath("dataloader", std::string(buffer) + "_const_text_embedding_out.raw")));
-#endif
 #ifdef PRELOAD_DATA
-        if (false == Helpers::readRawData((void *)const_text_embedding_ptr->data(),
-                                          const_text_embedding_ptr->size() * sizeof((*const_text_embedding_ptr)[0]),
+    // The constant embedding was quantized at Init, only the injected data replaces it per sample
+    {
+        const auto &dim = m_ModelInputImageDims[m_InputTensorName.first][m_InputTensorName.second];
+        tensor_data_float32_t const_text_embedding(dim.height * dim.width * dim.channel);
+        if (false == Helpers::readRawData((void *)const_text_embedding.data(),
+                                          const_text_embedding.size() * sizeof(const_text_embedding[0]),
                                           m_DemoDataFolder + "unet/sample_" + m_SampleNum + "/inputs/000_t3_uncond.bin"))
         {
             QNN_ERROR("There is an Error in reading the data from file");
             return false;
         }
-#endif
-
-        // Writing const embedding data into m_ConstTextEmbeddingQuantized
-        // Applying qunatization on const embedding data
-        for (size_t idx = 0; idx < const_text_embedding_ptr->size(); idx++)
-        {
-            double value = (*const_text_embedding_ptr)[idx] / m_UnetInQuantParam.scale - m_UnetInQuantParam.offset;
-            value = value < 0.0 ? 0.0 : value > 65535.0 ? 65535.0
-                                                        : value;
-            m_ConstTextEmbeddingQuantized[idx] = (uint16_t)value;
-        }
-        auto stop = std::chrono::steady_clock::now();
-        Helpers::logProfile("writing const-embedding input (cpp) took", start, stop);
+        if (true != writeConstTextEmbedding(const_text_embedding))
+            return false;
     }
+#endif
 
     // transfer data to shared variables for RunTime to process
     m_PreStagesData[m_pre_pingpong_index].overlayOnImage = overlayOnImage;
@@ -1256,40 +1527,32 @@ bool QnnApiHelpers::RunInference(
     auto &inference_count = m_inference_count;
     QNN_DEBUG("%s: START QNN Iteration %d", __FUNCTION__, inference_count);
 
-    // Getting text embedding buffer pointer of Unet (The app main input)
-    void *unet_text_embedding_buf_ip;
-    size_t unet_text_embedding_buf_ip_size;
+    // Writing the encoded Ts-embedding of this step into Unet Ts-Embedding tensor
     {
-        const auto &tensor = m_InputTensorsBufBank[m_infer_in_pingpong_index][m_InputTensorName.first][m_InputTensorName.second];
+        auto start = std::chrono::steady_clock::now();
+        const auto &dim = m_ModelInputImageDims[m_TsEmbedTensorName.first][m_TsEmbedTensorName.second];
+        const size_t ts_embedding_size = (size_t)(dim.height * dim.width * dim.channel);
+        const size_t ts_embedding_bytes = ts_embedding_size * m_TsEmbedCodec.elementSize();
+
+        // Getting ts-embedding buffer pointer
+        const auto &tensor = m_InputTensorsBufBank[m_infer_in_pingpong_index][m_TsEmbedTensorName.first][m_TsEmbedTensorName.second];
+        void *unet_ts_embedding_buf_ip;
         if (0 != m_qnnTensorMemorySet.count(tensor))
         {
-            unet_text_embedding_buf_ip = m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
-            unet_text_embedding_buf_ip_size = m_ioTensor->getBufferSize((Qnn_Tensor_t *)tensor);
+            unet_ts_embedding_buf_ip = m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
         }
         else
         {
-            unet_text_embedding_buf_ip = tensor;
-            unet_text_embedding_buf_ip_size = 0;
-        }
-    }
-
-    // Reading Ts-embedding data and Writing it into Unet Ts-Embedding tensor
-    {
-        auto start = std::chrono::steady_clock::now();
-        const tensor_data_float32_t *ts_embedding_ptr = nullptr;
-        m_offTargetDataLoader->get_ts_embedding(m_StepIdx, ts_embedding_ptr);
-
-        const auto &dim = m_ModelInputImageDims[m_TsEmbedTensorName.first][m_TsEmbedTensorName.second];
-        if (ts_embedding_ptr->size() != (unsigned long)(dim.height * dim.width * dim.channel))
-        {
-            QNN_ERROR("The Ts embedding data size %lu doesn't match with the size %lu of Ts embedding input of Unet",
-                      ts_embedding_ptr->size(), (unsigned long)(dim.height * dim.width * dim.channel));
-            return false;
+            unet_ts_embedding_buf_ip = tensor;
         }
+        std::memcpy(unet_ts_embedding_buf_ip, m_EncodedTsEmbeddings->data() + m_StepIdx * ts_embedding_bytes,
+                    ts_embedding_bytes);
 
 #ifdef DEBUG_DUMP
         char buffer[20];
         sprintf(buffer, "%03d", inference_count);
+        const tensor_view_float32_t *ts_embedding_ptr = nullptr;
+        m_TsEmbeddingCache->get_ts_embedding_by_time_step(m_schedulerSolver->getTimestep(m_StepIdx), ts_embedding_ptr);
         Helpers::writeRawData((void *)(&m_StepIdx), sizeof(m_StepIdx),
                               getDebugFile(Helpers::joinPath("dataloader", std::string(buffer) + "_step_index_in.raw")));
         Helpers::writeRawData((void *)ts_embedding_ptr->data(), ts_embedding_ptr->size() * sizeof((*ts_embedding_ptr)[0]),
@@ -1298,73 +1561,53 @@ bool QnnApiHelpers::RunInference(
 #ifdef PRELOAD_DATA
         char buffer1[20];
         sprintf(buffer1, "%03d", inference_count);
-        if (false == Helpers::readRawData((void *)ts_embedding_ptr->data(),
-                                          ts_embedding_ptr->size() * sizeof((*ts_embedding_ptr)[0]),
+        tensor_data_float32_t injected_ts_embedding(ts_embedding_size);
+        if (false == Helpers::readRawData((void *)injected_ts_embedding.data(),
+                                          injected_ts_embedding.size() * sizeof(injected_ts_embedding[0]),
                                           m_DemoDataFolder + "unet/sample_" + m_SampleNum + "/inputs/" + std::string(buffer1) + "_t4_timeembedding.bin"))
         {
             QNN_ERROR("There is an Error in reading the data from file");
             return false;
         }
+        m_TsEmbedCodec.encode(unet_ts_embedding_buf_ip, injected_ts_embedding.data(), injected_ts_embedding.size());
 #endif
-
-        // Getting ts-embedding buffer pointer
-        const auto &tensor = m_InputTensorsBufBank[m_infer_in_pingpong_index][m_TsEmbedTensorName.first][m_TsEmbedTensorName.second];
-        uint16_t *unet_ts_embedding_buf_ip;
-        if (0 != m_qnnTensorMemorySet.count(tensor))
-        {
-            unet_ts_embedding_buf_ip = (uint16_t *)m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
-        }
-        else
-        {
-            unet_ts_embedding_buf_ip = (uint16_t *)tensor;
-        }
-        // Applying qunatization on Ts-embedding data
-        for (size_t idx = 0; idx < ts_embedding_ptr->size(); idx++)
-        {
-            double value = (*ts_embedding_ptr)[idx] / m_TsEmbedQuantParam.scale - m_TsEmbedQuantParam.offset;
-            value = value < 0.0 ? 0.0 : value > 65535.0 ? 65535.0
-                                                        : value;
-            *unet_ts_embedding_buf_ip = (uint16_t)value;
-            unet_ts_embedding_buf_ip++;
-        }
         auto stop = std::chrono::steady_clock::now();
         Helpers::logProfile("writing Ts-embedding input (cpp) took", start, stop);
     }
 
-    // Writing Scheduler o/p into Unet Latent tensor
+    // Getting latent buffer pointer of Unet
+    void *unet_latent_buf_ip;
     {
-        auto start = std::chrono::steady_clock::now();
         const auto &tensor = m_InputTensorsBufBank[m_infer_in_pingpong_index][m_LatentTensorName.first][m_LatentTensorName.second];
-        uint16_t *latent_buf;
         if (0 != m_qnnTensorMemorySet.count(tensor))
         {
-            latent_buf = (uint16_t *)m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
+            unet_latent_buf_ip = m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
         }
         else
         {
-            latent_buf = (uint16_t *)tensor;
-        }
-        // Applying qunatization for Latent data
-        for (size_t idx = 0; idx < m_SchLatent.size(); idx++)
-        {
-            double value = m_SchLatent[idx] / m_LatentQuantParam.scale - m_LatentQuantParam.offset;
-            value = value < 0.0 ? 0.0 : value > 65535.0 ? 65535.0
-                                                        : value;
-            *latent_buf = (uint16_t)value;
-            latent_buf++;
+            unet_latent_buf_ip = tensor;
         }
+    }
+
+    // Writing Scheduler o/p into Unet Latent tensor, unless the previous scheduler step already did
+    if (false == m_LatentInputReady)
+    {
+        auto start = std::chrono::steady_clock::now();
+        // Applying qunatization for Latent data, folding in the scheduler's model input scaling
+        m_LatentCodec.encode(unet_latent_buf_ip, m_SchLatent.data(), m_SchLatent.size(),
+                             m_schedulerSolver->getModelInputScale(m_StepIdx));
         auto stop = std::chrono::steady_clock::now();
         Helpers::logProfile("writing scheduler into latent (cpp) took", start, stop);
     }
+    m_LatentInputReady = false;
 
-    // 1. Run for constant text embedding
-    std::memcpy((char *)unet_text_embedding_buf_ip, (char *)m_ConstTextEmbeddingQuantized.data(), unet_text_embedding_buf_ip_size);
+    // 1. Run for constant text embedding, its inputs already hold the quantized constant embedding
     // Execute inference
     {
         auto start = std::chrono::steady_clock::now();
         const auto &graphName = m_modelsExecOrder[UNET_MODEL_IDX];
-        if (true != ExecuteModel(m_InputTensorsBank[m_infer_in_pingpong_index][graphName],
-                                 m_OutputTensorsBank[m_infer_in_pingpong_index][graphName], graphName))
+        if (true != ExecuteModel(m_UncondUnetInputsBank[m_infer_in_pingpong_index],
+                                 m_UncondUnetOutputsBank[m_infer_in_pingpong_index], graphName))
             return false;
         auto stop = std::chrono::steady_clock::now();
         Helpers::logProfile("inference Unet-0 (cpp) took", start, stop);
@@ -1372,72 +1615,50 @@ bool QnnApiHelpers::RunInference(
 #ifdef DEBUG_DUMP
         char buffer[20];
         sprintf(buffer, "%03d", inference_count);
-        for (const auto &tensorNameMemory : m_InputTensorsBufBank[m_infer_in_pingpong_index][graphName])
+        for (const auto &tensorNameMemory : m_UncondUnetInputsBufBank[m_infer_in_pingpong_index])
         {
             writeTensorData((Qnn_Tensor_t *)(tensorNameMemory.second),
                             getDebugFile(Helpers::joinPath("unet_0", std::string(buffer) + "_" + tensorNameMemory.first + "_in.raw")));
         }
-        for (const auto &tensorNameMemory : m_OutputTensorsBufBank[m_infer_in_pingpong_index][graphName])
+        for (const auto &tensorNameMemory : m_UncondUnetOutputsBufBank[m_infer_in_pingpong_index])
         {
             writeTensorData((Qnn_Tensor_t *)(tensorNameMemory.second),
                             getDebugFile(Helpers::joinPath("unet_0", std::string(buffer) + "_" + tensorNameMemory.first + "_out.raw")));
         }
 #endif
     }
-    // Copy the output into m_PredBatchNoise
+    // Getting the prediction of the unconditional pass, the scheduler dequantizes it
+    void *unet_uncond_output_buf;
     {
-        auto start = std::chrono::steady_clock::now();
-        const auto &tensor = m_OutputTensorsBufBank[m_infer_in_pingpong_index][m_modelsExecOrder[UNET_MODEL_IDX]].begin()->second;
-        uint16_t *src;
+        const auto &tensor = m_UncondUnetOutputsBufBank[m_infer_in_pingpong_index].begin()->second;
         if (0 != m_qnnTensorMemorySet.count(tensor))
         {
-            src = (uint16_t *)m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
+            unet_uncond_output_buf = m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
         }
         else
         {
-            src = (uint16_t *)tensor;
-        }
-        // Applying de-qunatization on Unet output data
-        for (size_t idx = 0; idx < m_PredBatchNoise.size() / 2; idx++)
-        {
-            double value = ((double)(*src) + m_UnetOutQuantParam.offset) * m_UnetOutQuantParam.scale;
-            m_PredBatchNoise[idx] = (float32_t)value;
-            src++;
+            unet_uncond_output_buf = tensor;
         }
-        auto stop = std::chrono::steady_clock::now();
-        Helpers::logProfile("writing Unet-0 output (cpp) took", start, stop);
 
 #ifdef PRELOAD_DATA
         if (inference_count < INJECTED_LIMIT_COUNT)
         {
             char buffer1[20];
             sprintf(buffer1, "%03d", inference_count);
-            if (false == Helpers::readRawData((void *)m_PredBatchNoise.data(),
-                                              m_PredBatchNoise.size() * sizeof(m_PredBatchNoise[0]) / 2,
+            // The injected predictions are float32, encode them like the Unet would have produced them
+            std::vector<float32_t> injected(m_SchLatent.size());
+            if (false == Helpers::readRawData((void *)injected.data(), injected.size() * sizeof(injected[0]),
                                               m_DemoDataFolder + "unet/sample_" + m_SampleNum + "/outputs/" + std::string(buffer1) + "_t6_pred_uncond.bin"))
             {
                 QNN_ERROR("There is an Error in reading the data from file");
                 return false;
             }
+            m_UnetOutCodec.encode(unet_uncond_output_buf, injected.data(), injected.size());
         }
 #endif
     }
 
-    // 2. Run for user text embedding
-    // Getting text embedding buffer pointer from Text Encoder
-    void *text_encoder_text_embedding_buf_op;
-    {
-        const auto &tensor = m_OutputTensorsBufBank[m_infer_in_pingpong_index][m_modelsExecOrder[TEXT_ENCODER_MODEL_IDX]].begin()->second;
-        if (0 != m_qnnTensorMemorySet.count(tensor))
-        {
-            text_encoder_text_embedding_buf_op = m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
-        }
-        else
-        {
-            text_encoder_text_embedding_buf_op = tensor;
-        }
-    }
-    std::memcpy((char *)unet_text_embedding_buf_ip, (char *)text_encoder_text_embedding_buf_op, unet_text_embedding_buf_ip_size);
+    // 2. Run for user text embedding, the text embedding input shares the memory of the Text Encoder output
     // Execute inference
     {
         auto start = std::chrono::steady_clock::now();
@@ -1463,50 +1684,68 @@ bool QnnApiHelpers::RunInference(
         }
 #endif
     }
-    // Copy the output into m_PredBatchNoise
+    // Getting the prediction of the conditional pass
+    void *unet_cond_output_buf;
     {
-        auto start = std::chrono::steady_clock::now();
         const auto &tensor = m_OutputTensorsBufBank[m_infer_in_pingpong_index][m_modelsExecOrder[UNET_MODEL_IDX]].begin()->second;
-        uint16_t *src;
         if (0 != m_qnnTensorMemorySet.count(tensor))
         {
-            src = (uint16_t *)m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
+            unet_cond_output_buf = m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
         }
         else
         {
-            src = (uint16_t *)tensor;
-        }
-        // Applying de-qunatization on Unet output data
-        for (size_t idx = m_PredBatchNoise.size() / 2; idx < m_PredBatchNoise.size(); idx++)
-        {
-            double value = ((double)(*src) + m_UnetOutQuantParam.offset) * m_UnetOutQuantParam.scale;
-            m_PredBatchNoise[idx] = (float32_t)value;
-            src++;
+            unet_cond_output_buf = tensor;
         }
-        auto stop = std::chrono::steady_clock::now();
-        Helpers::logProfile("writing Unet-1 output (cpp) took", start, stop);
 
 #ifdef PRELOAD_DATA
         if (inference_count < INJECTED_LIMIT_COUNT)
         {
             char buffer1[20];
             sprintf(buffer1, "%03d", inference_count);
-            if (false == Helpers::readRawData((void *)((char *)m_PredBatchNoise.data() + (m_PredBatchNoise.size() * sizeof(m_PredBatchNoise[0]) / 2)),
-                                              m_PredBatchNoise.size() * sizeof(m_PredBatchNoise[0]) / 2,
+            std::vector<float32_t> injected(m_SchLatent.size());
+            if (false == Helpers::readRawData((void *)injected.data(), injected.size() * sizeof(injected[0]),
                                               m_DemoDataFolder + "unet/sample_" + m_SampleNum + "/outputs/" + std::string(buffer1) + "_t7_pred_cond.bin"))
             {
                 QNN_ERROR("There is an Error in reading the data from file");
                 return false;
             }
+            m_UnetOutCodec.encode(unet_cond_output_buf, injected.data(), injected.size());
         }
 #endif
     }
 
-    // Run Scheduler
+    // Run Scheduler. The step also quantizes its result for the model reading it next, the VAE after
+    // the last step and the Unet latent input of the next step otherwise, when that input is UFIXED16
+    bool vae_input_ready = false;
     {
         auto start = std::chrono::steady_clock::now();
-        int32_t timeStep;
-        m_offTargetDataLoader->get_time_step(m_StepIdx, timeStep);
+        int32_t timeStep = m_schedulerSolver->getTimestep(m_StepIdx);
+
+        QuantizedLatents next_input;
+        if (true == runVAE)
+        {
+            if (m_VaeInCodec.getType() == TensorDataType::UFIXED16)
+            {
+                const auto &tensor = m_InputTensorsBufBank[m_infer_in_pingpong_index][m_modelsExecOrder[VAE_MODEL_IDX]].begin()->second;
+                if (0 != m_qnnTensorMemorySet.count(tensor))
+                {
+                    next_input.data = (uint16_t *)m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
+                }
+                else
+                {
+                    next_input.data = (uint16_t *)tensor;
+                }
+                next_input.multiplier = (float32_t)(1.0 / m_VaeInCodec.getEncoding().scale);
+                next_input.bias = (float32_t)(-m_VaeInCodec.getEncoding().offset);
+            }
+        }
+        else if (m_StepIdx + 1 < (uint32_t)m_schedulerSolver->getNumInferenceSteps() &&
+                 m_LatentCodec.getType() == TensorDataType::UFIXED16)
+        {
+            next_input.data = (uint16_t *)unet_latent_buf_ip;
+            next_input.multiplier = (float32_t)(m_schedulerSolver->getModelInputScale(m_StepIdx + 1) / m_LatentCodec.getEncoding().scale);
+            next_input.bias = (float32_t)(-m_LatentCodec.getEncoding().offset);
+        }
 
 #ifdef DEBUG_DUMP
         char buffer[20];
@@ -1527,17 +1766,38 @@ bool QnnApiHelpers::RunInference(
 #ifdef DEBUG_DUMP
         Helpers::writeRawData((void *)m_SchLatent.data(), m_SchLatent.size() * sizeof(m_SchLatent[0]),
                               getDebugFile(Helpers::joinPath("scheduler", std::string(buffer) + "_latent_in.raw")));
-        Helpers::writeRawData((void *)m_PredBatchNoise.data(), m_PredBatchNoise.size() * sizeof(m_PredBatchNoise[0]),
-                              getDebugFile(Helpers::joinPath("scheduler", std::string(buffer) + "_pred_batch_noise_in.raw")));
+        Helpers::writeRawData(unet_uncond_output_buf, m_SchLatent.size() * m_UnetOutCodec.elementSize(),
+                              getDebugFile(Helpers::joinPath("scheduler", std::string(buffer) + "_pred_uncond_in.raw")));
+        Helpers::writeRawData(unet_cond_output_buf, m_SchLatent.size() * m_UnetOutCodec.elementSize(),
+                              getDebugFile(Helpers::joinPath("scheduler", std::string(buffer) + "_pred_cond_in.raw")));
         Helpers::writeRawData((void *)&timeStep, sizeof(timeStep),
                               getDebugFile(Helpers::joinPath("scheduler", std::string(buffer) + "_time_step_in.raw")));
 #endif
 
-        if (true != m_schedulerSolver->step((void *)m_PredBatchNoise.data(), timeStep, (void *)m_SchLatent.data(), (void *)m_SchLatent.data()))
+        // Dequantization and guidance run inside the scheduler step, on the raw UFIXED16 Unet outputs.
+        // Other output types are decoded into float32 first
+        bool step_done;
+        if (true == m_UnetOutputs.empty())
+        {
+            step_done = m_schedulerSolver->stepQuantized((const uint16_t *)unet_uncond_output_buf, (const uint16_t *)unet_cond_output_buf,
+                                                         m_UnetOutCodec.getEncoding().scale, m_UnetOutCodec.getEncoding().offset,
+                                                         m_StepIdx, (void *)m_SchLatent.data(), (void *)m_SchLatent.data(),
+                                                         nullptr != next_input.data ? &next_input : nullptr);
+        }
+        else
+        {
+            m_UnetOutCodec.decode(m_UnetOutputs.data(), unet_uncond_output_buf, m_SchLatent.size());
+            m_UnetOutCodec.decode(m_UnetOutputs.data() + m_SchLatent.size(), unet_cond_output_buf, m_SchLatent.size());
+            step_done = m_schedulerSolver->step((void *)m_UnetOutputs.data(), m_StepIdx,
+                                                (void *)m_SchLatent.data(), (void *)m_SchLatent.data());
+        }
+        if (true != step_done)
         {
             QNN_ERROR("There is an Error in running step-%d on Scheduler!", inference_count);
             return false;
         }
+        vae_input_ready = (true == runVAE) && (nullptr != next_input.data);
+        m_LatentInputReady = (false == runVAE) && (nullptr != next_input.data);
         auto stop = std::chrono::steady_clock::now();
         Helpers::logProfile("inference Scheduler (cpp) took", start, stop);
 
@@ -1554,6 +1814,9 @@ bool QnnApiHelpers::RunInference(
                 QNN_ERROR("There is an Error in reading the data from file");
                 return false;
             }
+            // The quantized copies written by the step are stale now
+            vae_input_ready = false;
+            m_LatentInputReady = false;
         }
 #endif
     }
@@ -1564,28 +1827,22 @@ bool QnnApiHelpers::RunInference(
     // Running VAE
     if (true == runVAE)
     {
-        // Writing Scheduler latent output data for VAE
+        // Writing Scheduler latent output data for VAE, unless the scheduler step already did
+        if (false == vae_input_ready)
         {
             auto start = std::chrono::steady_clock::now();
-            uint16_t *dst;
+            void *dst;
             const auto &tensor = m_InputTensorsBufBank[m_infer_in_pingpong_index][m_modelsExecOrder[VAE_MODEL_IDX]].begin()->second;
             if (0 != m_qnnTensorMemorySet.count(tensor))
             {
-                dst = (uint16_t *)m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
+                dst = m_ioTensor->getBuffer((Qnn_Tensor_t *)tensor);
             }
             else
             {
-                dst = (uint16_t *)tensor;
+                dst = tensor;
             }
             // Applying qunatization on Scheduler output data for VAE
-            for (size_t idx = 0; idx < m_SchLatent.size(); idx++)
-            {
-                double value = m_SchLatent[idx] / m_VaeInQuantParam.scale - m_VaeInQuantParam.offset;
-                value = value < 0.0 ? 0.0 : value > 65535.0 ? 65535.0
-                                                            : value;
-                *dst = (uint16_t)value;
-                dst++;
-            }
+            m_VaeInCodec.encode(dst, m_SchLatent.data(), m_SchLatent.size());
             auto stop = std::chrono::steady_clock::now();
             Helpers::logProfile("Writing VAE input data (cpp) took", start, stop);
         }
@@ -1639,6 +1896,96 @@ bool QnnApiHelpers::RunInference(
     return true;
 }
 
+uint32_t QnnApiHelpers::GetStepsToRun(uint32_t requestedSteps)
+{
+    // The scheduler moves its final step earlier once the latent converged
+    return std::min<uint32_t>(requestedSteps, m_schedulerSolver->getFinalStepIndex() + 1);
+}
+
+bool QnnApiHelpers::writeConstTextEmbedding(const tensor_view_float32_t &const_text_embedding)
+{
+    const auto &dim = m_ModelInputImageDims[m_InputTensorName.first][m_InputTensorName.second];
+    if (const_text_embedding.size() != (size_t)(dim.height * dim.width * dim.channel))
+    {
+        QNN_ERROR("The const embedding data size %lu doesn't match with the size %lu of embedding input of Unet",
+                  const_text_embedding.size(), (unsigned long)(dim.height * dim.width * dim.channel));
+        return false;
+    }
+
+    // Applying qunatization on const embedding data, for every input bank
+    for (auto &uncondInputsBuf : m_UncondUnetInputsBufBank)
+    {
+        const auto &tensor = (Qnn_Tensor_t *)uncondInputsBuf[m_InputTensorName.second];
+        m_UnetInCodec.encode(m_ioTensor->getBuffer(tensor), const_text_embedding.data(), const_text_embedding.size());
+    }
+    return true;
+}
+
+bool QnnApiHelpers::readTensorCodec(const Qnn_Tensor_t *tensor, const char *description, CpuFeatures::Isa isa,
+                                    TensorCodec &codec)
+{
+    TensorEncoding encoding;
+    switch (QNN_TENSOR_GET_DATA_TYPE(tensor))
+    {
+    case QNN_DATATYPE_UFIXED_POINT_8:  encoding.type = TensorDataType::UFIXED8;  break;
+    case QNN_DATATYPE_UFIXED_POINT_16: encoding.type = TensorDataType::UFIXED16; break;
+    case QNN_DATATYPE_SFIXED_POINT_8:  encoding.type = TensorDataType::SFIXED8;  break;
+    case QNN_DATATYPE_SFIXED_POINT_16: encoding.type = TensorDataType::SFIXED16; break;
+    case QNN_DATATYPE_FLOAT_16:        encoding.type = TensorDataType::FLOAT16;  break;
+    case QNN_DATATYPE_FLOAT_32:        encoding.type = TensorDataType::FLOAT32;  break;
+    default:
+        QNN_ERROR("The data type 0x%x of the %s is not supported", (unsigned)QNN_TENSOR_GET_DATA_TYPE(tensor), description);
+        return false;
+    }
+    if (encoding.isFixedPoint() && false == m_qnnApi->getTensorQuantStatus(tensor, encoding.scale, encoding.offset))
+    {
+        QNN_ERROR("The quantization parameters of the %s couldn't be read", description);
+        return false;
+    }
+    codec = TensorCodec(encoding, isa);
+    QNN_DEBUG("The %s is %s, scale=%f, offset=%d", description, TensorEncoding::typeName(encoding.type),
+              encoding.scale, encoding.offset);
+    return true;
+}
+
+bool QnnApiHelpers::CaptureDenoisingState(DenoisingState &state)
+{
+    if (true != m_schedulerSolver->captureState(state.scheduler))
+    {
+        QNN_ERROR("Error in capturing the scheduler state at step %u", m_StepIdx);
+        return false;
+    }
+    state.stepIdx = m_StepIdx;
+    state.latent = m_SchLatent;
+    return true;
+}
+
+bool QnnApiHelpers::RestoreDenoisingState(const DenoisingState &state)
+{
+    if (state.latent.size() != m_SchLatent.size())
+    {
+        QNN_ERROR("The captured latent size %lu doesn't match with the latent size %lu",
+                  state.latent.size(), m_SchLatent.size());
+        return false;
+    }
+    if (nullptr == state.scheduler.plan ||
+        m_schedulerSolver->getNumInferenceSteps() != (int32_t)state.scheduler.plan->steps.size())
+    {
+        QNN_ERROR("The branch has to run the same number of steps as the captured generation");
+        return false;
+    }
+    if (true != m_schedulerSolver->restoreState(state.scheduler))
+    {
+        QNN_ERROR("Error in restoring the scheduler state of step %u", state.stepIdx);
+        return false;
+    }
+    m_SchLatent = state.latent;
+    m_LatentInputReady = false;
+    m_StepIdx = state.stepIdx;
+    m_inference_count = state.stepIdx;
+    return true;
+}
+
 bool QnnApiHelpers::PostProcessOutput(
     bool showLabels,
     bool showConfScores,
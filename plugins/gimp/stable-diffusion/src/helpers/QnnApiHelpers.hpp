@@ -8,6 +8,7 @@
 #ifndef _QNNAPIHELPERS_HPP_
 #define _QNNAPIHELPERS_HPP_
 
+#include <future>
 
 //used for throwing errors back to Java
 #include "Helpers.hpp"
@@ -18,7 +19,9 @@
 
 #include "DataLoader.h"
 
-#include "Scheduler.hpp"
+#include "SchedulerFactory.hpp"
+#include "TensorCodec.hpp"
+#include "TorchGenerator.hpp"
 
 #include "StableDiffusionHelper.hpp"
 
@@ -65,6 +68,34 @@ public:
                            bool dumpPostOutput,
                            std::string outputLocation
                           );
+    uint32_t GetStepsToRun(uint32_t requestedSteps);
+
+    // Denoising state between two RunInference calls
+    struct DenoisingState
+    {
+        uint32_t stepIdx;
+        std::vector<float32_t> latent;
+        SchedulerState scheduler;
+    };
+
+    /**
+    * @brief captures the latent, the scheduler history and the step index reached by the
+             RunInference calls so far, so that variations can share these first steps
+    * @param state: receives the denoising state
+
+    * @return: true if no error, False otherwise
+    */
+    bool CaptureDenoisingState(DenoisingState &state);
+
+    /**
+    * @brief continues a generation from a captured state. Call it after the PreProcessInput of the
+             branch, which sets up its prompt, guidance scale and noise seed, and then run the
+             remaining steps. The branch must request the same number of steps.
+    * @param state: the state returned by CaptureDenoisingState
+
+    * @return: true if no error, False otherwise
+    */
+    bool RestoreDenoisingState(const DenoisingState &state);
 
     /**
     * @brief template function for executing HRNET. The input/ouput can be either user buffer or HRNET tensor.
@@ -126,6 +157,32 @@ private:
     */
     int32_t parseConfigPath(std::string configFilePath);
 
+    /**
+    * @brief quantizes the constant text embedding into the text embedding input of the unconditional Unet pass
+    * @param const_text_embedding: the float constant text embedding from the data loader
+
+    * @return: true if no error, False otherwise
+    */
+    bool writeConstTextEmbedding(const tensor_view_float32_t &const_text_embedding);
+
+    /**
+    * @brief reads the data type and the encoding of a tensor converted on the CPU
+    * @param tensor: the QNN tensor
+    * @param description: names the tensor in the logs
+    * @param isa: instruction set of the conversion kernels
+    * @param codec: receives the conversions from and to float32 of the tensor
+
+    * @return: true if no error, False when the data type can't be converted
+    */
+    bool readTensorCodec(const Qnn_Tensor_t *tensor, const char *description, CpuFeatures::Isa isa,
+                         TensorCodec &codec);
+
+    /**
+    * @brief tears down the Unet tensors of the unconditional pass and empties their banks, also when
+    *        Init stopped half way through creating them
+    */
+    void tearDownUncondUnetBanks();
+
     // QNN specific variables
     std::unique_ptr<QnnApi> m_qnnApi;
 
@@ -136,34 +193,65 @@ private:
     bool m_sharedBuffer{false};
     std::unique_ptr<IOTensor> m_ioTensor;
 
-    // Off-Target Data loader specific variable
-    DataLoader* m_offTargetDataLoader;
+    // Off-Target Data loader specific variable, read-only once loaded so it can be shared
+    std::shared_ptr<const DataLoader> m_offTargetDataLoader;
     std::string m_dataLoaderInputTarfile;
 
+    // Ts embeddings of this session in the Unet input encoding, on top of the shared data loader
+    std::unique_ptr<TsEmbeddingCache> m_TsEmbeddingCache;
+    // Ts embeddings of every step of the current schedule in the input encoding, owned by m_TsEmbeddingCache
+    const std::vector<uint8_t>* m_EncodedTsEmbeddings{nullptr};
+
     // Scheduler specific variables
-    DPMSolverMultistepScheduler* m_schedulerSolver;
-    // Memory variable to point the memory for 'batch noise pred.' - one of the inputs to Scheduler
-    std::vector<float32_t> m_PredBatchNoise;
+    std::unique_ptr<Scheduler> m_schedulerSolver;
+    // Scheduler picked by the optional 'scheduler_type' config key, "dpmsolver++" by default
+    std::string m_SchedulerType;
+    // Optional 'timestep_spacing' config key, empty keeps the scheduler's own default
+    std::string m_TimestepSpacing;
+    // Optional 'adaptive_tolerance' config key, 0 always runs every requested step
+    float32_t m_AdaptiveTolerance;
+    // Optional 'latent_source' config key: "generated" by default draws the initial latent of any
+    // seed like torch.randn, "precomputed" takes the seed as an index into the data loader latents
+    std::string m_LatentSource;
+    TorchGenerator m_LatentGenerator;
     // Memory variable to point the memory for 'scheduler latent' - one of the inputs to and output from Scheduler
     std::vector<float32_t> m_SchLatent;
-
-    // Memory to hold quantized constant text embedding data 
-    std::vector<uint16_t> m_ConstTextEmbeddingQuantized;
-
-    // Variables to hold quantized parameters for Text Encoder
-    Helpers::QuantParameters m_TeOutQuantParam;
-
-    // Variables to hold quantized parameters for UNET
-    Helpers::QuantParameters m_UnetInQuantParam;
-    Helpers::QuantParameters m_LatentQuantParam;
-    Helpers::QuantParameters m_TsEmbedQuantParam;
-    Helpers::QuantParameters m_UnetOutQuantParam;
-
-    // Variables to hold quantized parameters for VAE
-    Helpers::QuantParameters m_VaeInQuantParam;
+    // Set once a scheduler step wrote m_SchLatent quantized into the Unet latent input of the next step
+    bool m_LatentInputReady{false};
+    // Float32 Unet predictions, unconditional then conditional, read by the scheduler when the Unet
+    // output isn't UFIXED16. Empty otherwise
+    std::vector<float32_t> m_UnetOutputs;
+
+    // Unet input tensors of the unconditional pass, one set per input bank. They share the latent and
+    // Ts-embedding memory of m_InputTensorsBank, their text embedding holds the constant embedding quantized at Init
+    std::vector<Qnn_Tensor_t*> m_UncondUnetInputsBank;
+    std::vector<std::unordered_map<std::string, void*>> m_UncondUnetInputsBufBank;
+    // Unet output tensors of the unconditional pass, one set per output bank, read by the scheduler
+    // next to the conditional output of m_OutputTensorsBank
+    std::vector<Qnn_Tensor_t*> m_UncondUnetOutputsBank;
+    std::vector<std::unordered_map<std::string, void*>> m_UncondUnetOutputsBufBank;
+
+    // Conversions of the tensors the CPU reads or writes, following their data type and encoding
+    // Text Encoder
+    TensorCodec m_TeOutCodec;
+
+    // Text Encoder output value to Unet embedding input value, for every uint16. Only used when both
+    // tensors are UFIXED16 with different encodings
+    std::vector<uint16_t> m_TeToUnetRequantLut;
+
+    // UNET
+    TensorCodec m_UnetInCodec;
+    TensorCodec m_LatentCodec;
+    TensorCodec m_TsEmbedCodec;
+    TensorCodec m_UnetOutCodec;
+
+    // VAE
+    TensorCodec m_VaeInCodec;
 
     // Tokenizer specific variables
     uint32_t m_TokenIds[TOKEN_IDS_LEN];
+    // Tokenizer warm-up started by Init, the first PreProcessInput waits for it
+    std::future<void> m_TokenizerReady;
 
     // Variable to hold the path on-device where all data files reside
     std::string m_DemoDataFolder;
@@ -0,0 +1,200 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#include "QuantKernels.hpp"
+
+#if defined(CPU_FEATURES_X86_64)
+#include <immintrin.h>
+#elif defined(CPU_FEATURES_ARM64)
+#include <arm_neon.h>
+#endif
+
+#define QUANT_MAX 65535.0f
+
+namespace scalar {
+
+static inline uint16_t clampToUint16(float32_t value)
+{
+    value = value < 0.0f ? 0.0f : value > QUANT_MAX ? QUANT_MAX
+                                                    : value;
+    return (uint16_t)value;
+}
+
+static void quantize(uint16_t* q, const float32_t* x, float32_t multiplier, float32_t offset, int64_t n)
+{
+    for (int64_t i = 0; i < n; i++)
+        q[i] = clampToUint16(x[i] * multiplier - offset);
+}
+
+static void dequantize(float32_t* x, const uint16_t* q, float32_t scale, float32_t bias, int64_t n)
+{
+    for (int64_t i = 0; i < n; i++)
+        x[i] = (float32_t)q[i] * scale + bias;
+}
+
+static void requantize(uint16_t* out, const uint16_t* q, float32_t multiplier, float32_t bias, int64_t n)
+{
+    for (int64_t i = 0; i < n; i++)
+        out[i] = clampToUint16((float32_t)q[i] * multiplier + bias);
+}
+
+static const QuantKernels kKernels = { quantize, dequantize, requantize };
+
+} // namespace scalar
+
+#if defined(CPU_FEATURES_X86_64)
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+namespace avx2 {
+
+// Clamps 16 floats and packs them into 16 uint16
+static inline __m256i packToUint16(__m256 lo, __m256 hi)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 max = _mm256_set1_ps(QUANT_MAX);
+    __m256i a = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(lo, zero), max));
+    __m256i b = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(hi, zero), max));
+    // packus works per 128 bit lane, restore the element order afterwards
+    return _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xd8);
+}
+
+static inline __m256 loadUint16(const uint16_t* q)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)q)));
+}
+
+static void quantize(uint16_t* q, const float32_t* x, float32_t multiplier, float32_t offset, int64_t n)
+{
+    const __m256 m = _mm256_set1_ps(multiplier);
+    const __m256 o = _mm256_set1_ps(offset);
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256 lo = _mm256_fmsub_ps(_mm256_loadu_ps(x + i), m, o);
+        __m256 hi = _mm256_fmsub_ps(_mm256_loadu_ps(x + i + 8), m, o);
+        _mm256_storeu_si256((__m256i*)(q + i), packToUint16(lo, hi));
+    }
+    scalar::quantize(q + i, x + i, multiplier, offset, n - i);
+}
+
+static void dequantize(float32_t* x, const uint16_t* q, float32_t scale, float32_t bias, int64_t n)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 b = _mm256_set1_ps(bias);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(x + i, _mm256_fmadd_ps(loadUint16(q + i), s, b));
+    }
+    scalar::dequantize(x + i, q + i, scale, bias, n - i);
+}
+
+static void requantize(uint16_t* out, const uint16_t* q, float32_t multiplier, float32_t bias, int64_t n)
+{
+    const __m256 m = _mm256_set1_ps(multiplier);
+    const __m256 b = _mm256_set1_ps(bias);
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256 lo = _mm256_fmadd_ps(loadUint16(q + i), m, b);
+        __m256 hi = _mm256_fmadd_ps(loadUint16(q + i + 8), m, b);
+        _mm256_storeu_si256((__m256i*)(out + i), packToUint16(lo, hi));
+    }
+    scalar::requantize(out + i, q + i, multiplier, bias, n - i);
+}
+
+static const QuantKernels kKernels = { quantize, dequantize, requantize };
+
+} // namespace avx2
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#elif defined(CPU_FEATURES_ARM64)
+
+namespace neon {
+
+// Clamps 8 floats and narrows them into 8 uint16
+static inline uint16x8_t packToUint16(float32x4_t lo, float32x4_t hi)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t max = vdupq_n_f32(QUANT_MAX);
+    uint32x4_t a = vcvtq_u32_f32(vminq_f32(vmaxq_f32(lo, zero), max));
+    uint32x4_t b = vcvtq_u32_f32(vminq_f32(vmaxq_f32(hi, zero), max));
+    return vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+}
+
+static void quantize(uint16_t* q, const float32_t* x, float32_t multiplier, float32_t offset, int64_t n)
+{
+    const float32x4_t m = vdupq_n_f32(multiplier);
+    const float32x4_t o = vdupq_n_f32(-offset);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        float32x4_t lo = vfmaq_f32(o, vld1q_f32(x + i), m);
+        float32x4_t hi = vfmaq_f32(o, vld1q_f32(x + i + 4), m);
+        vst1q_u16(q + i, packToUint16(lo, hi));
+    }
+    scalar::quantize(q + i, x + i, multiplier, offset, n - i);
+}
+
+static void dequantize(float32_t* x, const uint16_t* q, float32_t scale, float32_t bias, int64_t n)
+{
+    const float32x4_t s = vdupq_n_f32(scale);
+    const float32x4_t b = vdupq_n_f32(bias);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint16x8_t v = vld1q_u16(q + i);
+        vst1q_f32(x + i, vfmaq_f32(b, vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))), s));
+        vst1q_f32(x + i + 4, vfmaq_f32(b, vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))), s));
+    }
+    scalar::dequantize(x + i, q + i, scale, bias, n - i);
+}
+
+static void requantize(uint16_t* out, const uint16_t* q, float32_t multiplier, float32_t bias, int64_t n)
+{
+    const float32x4_t m = vdupq_n_f32(multiplier);
+    const float32x4_t b = vdupq_n_f32(bias);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint16x8_t v = vld1q_u16(q + i);
+        float32x4_t lo = vfmaq_f32(b, vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))), m);
+        float32x4_t hi = vfmaq_f32(b, vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))), m);
+        vst1q_u16(out + i, packToUint16(lo, hi));
+    }
+    scalar::requantize(out + i, q + i, multiplier, bias, n - i);
+}
+
+static const QuantKernels kKernels = { quantize, dequantize, requantize };
+
+} // namespace neon
+
+#endif
+
+const QuantKernels& getQuantKernels(CpuFeatures::Isa isa)
+{
+    switch (isa)
+    {
+#if defined(CPU_FEATURES_X86_64)
+    case CpuFeatures::Isa::AVX512:
+    case CpuFeatures::Isa::AVX2:
+        return avx2::kKernels;
+#elif defined(CPU_FEATURES_ARM64)
+    case CpuFeatures::Isa::NEON:
+        return neon::kKernels;
+#endif
+    default:
+        return scalar::kKernels;
+    }
+}
@@ -0,0 +1,36 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#ifndef _QUANTKERNELS_HPP_
+#define _QUANTKERNELS_HPP_
+
+#include <cstdint>
+
+#include "CpuFeatures.hpp"
+
+#ifndef float32_t
+using float32_t = float;
+#endif
+
+// Conversions between float32 and the 16 bit affine encoding of the QNN tensors,
+// real = (quantized + offset) * scale. The callers fold the scales into the float32
+// multipliers once per tensor, so no kernel divides. Quantized values are clamped to
+// [0, 65535] and truncated like the scalar reference.
+struct QuantKernels {
+    // q = clamp(x * multiplier - offset), multiplier = 1 / scale times any extra input scaling
+    void (*quantize)(uint16_t* q, const float32_t* x, float32_t multiplier, float32_t offset, int64_t n);
+
+    // x = q * scale + bias, bias = offset * scale
+    void (*dequantize)(float32_t* x, const uint16_t* q, float32_t scale, float32_t bias, int64_t n);
+
+    // out = clamp(q * multiplier + bias), moves q from one encoding to another in a single pass
+    void (*requantize)(uint16_t* out, const uint16_t* q, float32_t multiplier, float32_t bias, int64_t n);
+};
+
+// Returns the kernel table for the given ISA, AVX-512 uses the AVX2 kernels. Falls back to
+// the scalar table when the ISA was not compiled in for this target.
+const QuantKernels& getQuantKernels(CpuFeatures::Isa isa);
+
+#endif
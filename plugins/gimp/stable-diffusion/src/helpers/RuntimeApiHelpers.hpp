@@ -187,6 +187,15 @@ public:
                                    std::string outputLocation="."
                                   ) = 0;
 
+    /**
+    * @brief number of RunInference calls the current generation needs. A runtime with an adaptive
+             scheduler can finish before the requested steps, so callers query it after every step
+    * @param requestedSteps: the step count that was given to PreProcessInput
+
+    * @return: steps to run in total, at most requestedSteps
+    */
+    virtual uint32_t GetStepsToRun(uint32_t requestedSteps) { return requestedSteps; }
+
 
     //////////////////////////////////////////////////////////////////////////////////////////////////
     // The following functions are the common functions and can be used across all runtimes.        //
@@ -0,0 +1,248 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#include "TensorCodec.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// Elements converted per pass when two encodings meet through float32
+#define CONVERT_CHUNK 1024
+
+namespace {
+
+template <class T>
+static void quantizeFixed(T* q, const float32_t* x, float32_t multiplier, float32_t offset, int64_t n,
+                          float32_t min, float32_t max)
+{
+    for (int64_t i = 0; i < n; i++)
+    {
+        float32_t value = x[i] * multiplier - offset;
+        value = value < min ? min : value > max ? max
+                                                : value;
+        q[i] = (T)value;
+    }
+}
+
+template <class T>
+static void dequantizeFixed(float32_t* x, const T* q, float32_t scale, float32_t bias, int64_t n)
+{
+    for (int64_t i = 0; i < n; i++)
+        x[i] = (float32_t)q[i] * scale + bias;
+}
+
+// IEEE half precision conversions, rounding to nearest even
+static inline uint16_t floatToHalf(float32_t value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    bits &= 0x7fffffff;
+
+    // Infinity and NaN, keeping NaNs quiet
+    if (bits >= 0x7f800000)
+        return sign | 0x7c00 | (bits > 0x7f800000 ? 0x200 : 0);
+    // From 65520 on the value rounds past the largest half
+    if (bits >= 0x477ff000)
+        return sign | 0x7c00;
+    // Subnormal halves, in units of 2^-24
+    if (bits < 0x38800000)
+    {
+        if (bits < 0x33000000)
+            return sign;
+        const uint32_t shift = 126 - (bits >> 23);
+        const uint32_t mantissa = (bits & 0x7fffff) | 0x800000;
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t tie = 1u << (shift - 1);
+        if (rest > tie || (rest == tie && (half & 1)))
+            half++;
+        return sign | (uint16_t)half;
+    }
+    // Normal halves, rebiasing the exponent from 127 to 15
+    bits += 0xfff + ((bits >> 13) & 1);
+    return sign | (uint16_t)((bits - 0x38000000) >> 13);
+}
+
+static inline float32_t halfToFloat(uint16_t half)
+{
+    const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1f;
+    const uint32_t mantissa = half & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0x1f)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else
+    {
+        const float32_t value = (float32_t)mantissa * 5.9604644775390625e-8f;
+        return sign ? -value : value;
+    }
+    float32_t value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+size_t TensorEncoding::elementSize() const
+{
+    switch (type)
+    {
+    case TensorDataType::UFIXED8:
+    case TensorDataType::SFIXED8:
+        return 1;
+    case TensorDataType::UFIXED16:
+    case TensorDataType::SFIXED16:
+    case TensorDataType::FLOAT16:
+        return 2;
+    case TensorDataType::FLOAT32:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+bool TensorEncoding::isFixedPoint() const
+{
+    return type == TensorDataType::UFIXED8 || type == TensorDataType::UFIXED16 ||
+           type == TensorDataType::SFIXED8 || type == TensorDataType::SFIXED16;
+}
+
+const char* TensorEncoding::typeName(TensorDataType type)
+{
+    switch (type)
+    {
+    case TensorDataType::UFIXED8:  return "UFIXED8";
+    case TensorDataType::UFIXED16: return "UFIXED16";
+    case TensorDataType::SFIXED8:  return "SFIXED8";
+    case TensorDataType::SFIXED16: return "SFIXED16";
+    case TensorDataType::FLOAT16:  return "FLOAT16";
+    case TensorDataType::FLOAT32:  return "FLOAT32";
+    default:                       return "unsupported";
+    }
+}
+
+bool TensorEncoding::operator==(const TensorEncoding& other) const
+{
+    if (type != other.type)
+        return false;
+    return !isFixedPoint() || (scale == other.scale && offset == other.offset);
+}
+
+TensorCodec::TensorCodec(const TensorEncoding& encoding, CpuFeatures::Isa isa)
+    : m_Encoding(encoding), m_QuantKernels(&getQuantKernels(isa))
+{
+}
+
+void TensorCodec::encode(void* dst, const float32_t* src, int64_t n, double input_scale) const
+{
+    const float32_t multiplier = (float32_t)(input_scale / m_Encoding.scale);
+    const float32_t float_scale = (float32_t)input_scale;
+    const float32_t offset = (float32_t)m_Encoding.offset;
+    switch (m_Encoding.type)
+    {
+    case TensorDataType::UFIXED16:
+        m_QuantKernels->quantize((uint16_t*)dst, src, multiplier, offset, n);
+        break;
+    case TensorDataType::UFIXED8:
+        quantizeFixed((uint8_t*)dst, src, multiplier, offset, n, 0.0f, 255.0f);
+        break;
+    case TensorDataType::SFIXED16:
+        quantizeFixed((int16_t*)dst, src, multiplier, offset, n, -32768.0f, 32767.0f);
+        break;
+    case TensorDataType::SFIXED8:
+        quantizeFixed((int8_t*)dst, src, multiplier, offset, n, -128.0f, 127.0f);
+        break;
+    case TensorDataType::FLOAT16:
+    {
+        uint16_t* half = (uint16_t*)dst;
+        for (int64_t i = 0; i < n; i++)
+            half[i] = floatToHalf(src[i] * float_scale);
+        break;
+    }
+    case TensorDataType::FLOAT32:
+        if (input_scale == 1.0)
+        {
+            std::memmove(dst, src, n * sizeof(float32_t));
+        }
+        else
+        {
+            float32_t* value = (float32_t*)dst;
+            for (int64_t i = 0; i < n; i++)
+                value[i] = src[i] * float_scale;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void TensorCodec::decode(float32_t* dst, const void* src, int64_t n) const
+{
+    const float32_t scale = (float32_t)m_Encoding.scale;
+    const float32_t bias = (float32_t)(m_Encoding.offset * m_Encoding.scale);
+    switch (m_Encoding.type)
+    {
+    case TensorDataType::UFIXED16:
+        m_QuantKernels->dequantize(dst, (const uint16_t*)src, scale, bias, n);
+        break;
+    case TensorDataType::UFIXED8:
+        dequantizeFixed(dst, (const uint8_t*)src, scale, bias, n);
+        break;
+    case TensorDataType::SFIXED16:
+        dequantizeFixed(dst, (const int16_t*)src, scale, bias, n);
+        break;
+    case TensorDataType::SFIXED8:
+        dequantizeFixed(dst, (const int8_t*)src, scale, bias, n);
+        break;
+    case TensorDataType::FLOAT16:
+    {
+        const uint16_t* half = (const uint16_t*)src;
+        for (int64_t i = 0; i < n; i++)
+            dst[i] = halfToFloat(half[i]);
+        break;
+    }
+    case TensorDataType::FLOAT32:
+        std::memmove(dst, src, n * sizeof(float32_t));
+        break;
+    default:
+        break;
+    }
+}
+
+void TensorCodec::convertFrom(void* dst, const void* src, const TensorCodec& from, int64_t n) const
+{
+    const TensorEncoding& source = from.getEncoding();
+    if (source == m_Encoding)
+    {
+        if (dst != src)
+            std::memmove(dst, src, n * elementSize());
+        return;
+    }
+    // Between two 16 bit encodings the data moves in a single pass
+    if (source.type == TensorDataType::UFIXED16 && m_Encoding.type == TensorDataType::UFIXED16)
+    {
+        const double multiplier = source.scale / m_Encoding.scale;
+        const double bias = source.offset * multiplier - m_Encoding.offset;
+        m_QuantKernels->requantize((uint16_t*)dst, (const uint16_t*)src, (float32_t)multiplier, (float32_t)bias, n);
+        return;
+    }
+
+    float32_t chunk[CONVERT_CHUNK];
+    const size_t src_size = source.elementSize();
+    const size_t dst_size = elementSize();
+    for (int64_t i = 0; i < n; i += CONVERT_CHUNK)
+    {
+        const int64_t count = std::min<int64_t>(CONVERT_CHUNK, n - i);
+        from.decode(chunk, (const uint8_t*)src + i * src_size, count);
+        encode((uint8_t*)dst + i * dst_size, chunk, count);
+    }
+}
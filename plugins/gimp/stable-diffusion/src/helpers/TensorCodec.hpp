@@ -0,0 +1,69 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#ifndef _TENSORCODEC_HPP_
+#define _TENSORCODEC_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "QuantKernels.hpp"
+
+// Element types of the QNN tensors the pipeline reads and writes on the CPU
+enum class TensorDataType {
+    UNSUPPORTED = 0,
+    UFIXED8,
+    UFIXED16,
+    SFIXED8,
+    SFIXED16,
+    FLOAT16,
+    FLOAT32
+};
+
+// Data type and affine encoding of a tensor, real = (stored + offset) * scale for the fixed point
+// types. Scale and offset are ignored by the float types.
+struct TensorEncoding {
+    TensorDataType type = TensorDataType::UNSUPPORTED;
+    double scale = 1.0;
+    int32_t offset = 0;
+
+    size_t elementSize() const;
+    bool isFixedPoint() const;
+    static const char* typeName(TensorDataType type);
+
+    bool operator==(const TensorEncoding& other) const;
+    bool operator!=(const TensorEncoding& other) const { return !(*this == other); }
+};
+
+// Converts float32 data from and to the element type of one tensor. The encoding is read once at
+// Init, every call then goes straight to the kernel of that type: the SIMD QuantKernels for
+// UFIXED16, plain loops for the other types, and memcpy when the tensor already holds float32.
+// Fixed point values are clamped to the range of the type and truncated like QuantKernels.
+class TensorCodec {
+public:
+    TensorCodec() = default;
+    TensorCodec(const TensorEncoding& encoding, CpuFeatures::Isa isa);
+
+    const TensorEncoding& getEncoding() const { return m_Encoding; }
+    TensorDataType getType() const { return m_Encoding.type; }
+    size_t elementSize() const { return m_Encoding.elementSize(); }
+
+    // Writes n elements of src * input_scale into dst, input_scale folds a scaling of the data into
+    // the conversion
+    void encode(void* dst, const float32_t* src, int64_t n, double input_scale = 1.0) const;
+
+    // Writes n elements of src as float32 into dst
+    void decode(float32_t* dst, const void* src, int64_t n) const;
+
+    // Re-encodes n elements of src, stored with the encoding of the codec from, into dst. Only copies
+    // when both encodings match. dst may be src when both element types have the same size.
+    void convertFrom(void* dst, const void* src, const TensorCodec& from, int64_t n) const;
+
+private:
+    TensorEncoding m_Encoding;
+    const QuantKernels* m_QuantKernels = nullptr;
+};
+
+#endif
@@ -0,0 +1,83 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#include "TorchGenerator.hpp"
+
+#include <cmath>
+
+// Uniforms turned into normals per Box-Muller pass, as in PyTorch's normal_fill
+#define NORMAL_BLOCK 16
+
+namespace {
+
+// at::uniform_real_distribution<float>(0, 1), 24 random bits scaled into [0, 1)
+static inline void fillUniform(float32_t* u, int64_t n, std::mt19937& engine)
+{
+    for (int64_t i = 0; i < n; i++)
+        u[i] = (float32_t)(engine() & 0xffffff) * (1.0f / 16777216.0f);
+}
+
+// normal_fill_16 of PyTorch, the first 8 uniforms give the radii and the last 8 the angles. The
+// operations and their precision follow it, so the results are identical as long as std::log,
+// std::cos and std::sin round like the libm PyTorch was built with. It stays scalar like PyTorch's
+// normal_fill, vectorized log/sincos approximations would round differently
+static inline void boxMuller16(float32_t* data)
+{
+    for (int j = 0; j < NORMAL_BLOCK / 2; j++)
+    {
+        const float32_t u1 = 1 - data[j];
+        const float32_t u2 = data[j + NORMAL_BLOCK / 2];
+        const float32_t radius = std::sqrt(-2 * std::log(u1));
+        const float32_t theta = (float32_t)(2.0f * 3.14159265358979323846 * u2);
+        data[j] = radius * std::cos(theta);
+        data[j + NORMAL_BLOCK / 2] = radius * std::sin(theta);
+    }
+}
+
+} // namespace
+
+TorchGenerator::TorchGenerator(uint64_t seed)
+{
+    manualSeed(seed);
+}
+
+void TorchGenerator::manualSeed(uint64_t seed)
+{
+    m_Engine.seed((uint32_t)(seed & 0xffffffff));
+}
+
+bool TorchGenerator::randn(float32_t* x, int64_t n)
+{
+    if (n < NORMAL_BLOCK)
+        return false;
+
+    // All the uniforms are drawn first, then transformed in place block by block
+    fillUniform(x, n, m_Engine);
+    for (int64_t i = 0; i + NORMAL_BLOCK <= n; i += NORMAL_BLOCK)
+        boxMuller16(x + i);
+    // The last partial block is redrawn over the tail of the last full one
+    if (n % NORMAL_BLOCK != 0)
+    {
+        float32_t* tail = x + n - NORMAL_BLOCK;
+        fillUniform(tail, NORMAL_BLOCK, m_Engine);
+        boxMuller16(tail);
+    }
+    return true;
+}
+
+bool TorchGenerator::randnLatent(float32_t* x, int32_t height, int32_t width, int32_t channel)
+{
+    const int64_t plane = (int64_t)height * width;
+    m_Planar.resize(plane * channel);
+    if (!randn(m_Planar.data(), (int64_t)m_Planar.size()))
+        return false;
+
+    for (int64_t p = 0; p < plane; p++)
+    {
+        for (int32_t c = 0; c < channel; c++)
+            x[p * channel + c] = m_Planar[c * plane + p];
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#ifndef _TORCHGENERATOR_HPP_
+#define _TORCHGENERATOR_HPP_
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#ifndef float32_t
+using float32_t = float;
+#endif
+
+// Draws the same float32 values as the CPU generator of PyTorch, torch.Generator().manual_seed(seed),
+// so that a seed gives the initial latent of the diffusers pipelines without precomputed data.
+// PyTorch runs the standard MT19937 on the low 32 bits of the seed, takes 24 bits of every output as
+// a uniform float and turns each block of 16 uniforms into normals with Box-Muller in float32.
+// The uniforms are exact, the normals can differ in the last bit where the math library rounds
+// std::log, std::cos or std::sin differently from the one of the PyTorch build.
+class TorchGenerator {
+public:
+    // PyTorch's default seed
+    explicit TorchGenerator(uint64_t seed = 67280421310721ull);
+
+    void manualSeed(uint64_t seed);
+
+    // torch.randn(n) in float32. PyTorch only takes the Box-Muller blocks path from 16 elements on,
+    // smaller tensors aren't supported
+    bool randn(float32_t* x, int64_t n);
+
+    // torch.randn((1, channel, height, width)) of the diffusers pipelines, stored in the NHWC order
+    // of the Unet latent input
+    bool randnLatent(float32_t* x, int32_t height, int32_t width, int32_t channel);
+
+private:
+    std::mt19937 m_Engine;
+    std::vector<float32_t> m_Planar;
+};
+
+#endif
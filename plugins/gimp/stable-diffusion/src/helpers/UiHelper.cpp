@@ -77,9 +77,9 @@ void UiHelper::reinit() {
 
 
 
-bool UiHelper::executeStableDiffusion(int seed, int step, float scale, std::string input_text) {
+bool UiHelper::executeStableDiffusion(int64_t seed, int step, float scale, std::string input_text) {
     std::string text = input_text.substr(1);
-    char buffer[1024]; sprintf(buffer, "%010d%010d%010f%s", seed, step, scale, text.c_str());
+    char buffer[1024]; sprintf(buffer, "%020lld%010d%010f%s", (long long)seed, step, scale, text.c_str());
 
     std::string full_text(buffer);
     auto start = std::chrono::steady_clock::now();
@@ -89,9 +89,11 @@ bool UiHelper::executeStableDiffusion(int seed, int step, float scale, std::stri
         return false;
     }
 
-    for (int mStepIdx = 0; mStepIdx < step; mStepIdx++) {
+    // The adaptive scheduler mode can end the generation before the requested steps
+    int stepsToRun = step;
+    for (int mStepIdx = 0; mStepIdx < stepsToRun; mStepIdx++) {
         
-        bool runVAE = ((mStepIdx + 1) == step);
+        bool runVAE = ((mStepIdx + 1) == stepsToRun);
         printf("\n");
         if (true != app->RunInference(runVAE)) {
             printf("RunInference failure");
@@ -107,8 +109,12 @@ bool UiHelper::executeStableDiffusion(int seed, int step, float scale, std::stri
             app->unlockPostProcessBufferAccess();
             convertOutputImageToCV();
         }
+        else {
+            stepsToRun = app->GetStepsToRun(step);
+        }
         step_number = mStepIdx;
     }
+    std::cout << "Denoising used " << stepsToRun << " of " << step << " steps" << std::endl;
     auto stop = std::chrono::steady_clock::now();
     Helpers::logProfile("Overall Inference time: ", start, stop);
     auto now = std::chrono::system_clock::now();
@@ -34,7 +34,7 @@ public:
 	UiHelper(std::string config_path, std::string backend, std::string model_version);
 	~UiHelper();
 	bool init();
-	bool executeStableDiffusion(int seed, int step, float scale, std::string input_text);
+	bool executeStableDiffusion(int64_t seed, int step, float scale, std::string input_text);
 	void convertOutputImageToCV();
 	cv::Mat getOutputImageCV();
 	cv::Mat outputModelImage;	
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <filesystem>
 #include <memory>
+#include <random>
 #include <string>
 
 #include "GetOpt.hpp"
@@ -189,7 +190,7 @@ bool processCommandLine(int argc,
     std::string systemLibraryPath;
     std::string prompt;
     std::string model_version = VERSION_1_5;
-    int seed = 0;
+    int64_t seed = 0;
     float guidance_scale = 7.5;
     int step = 20;
     int num_images = 1;
@@ -274,7 +275,16 @@ bool processCommandLine(int argc,
                 token = strtok(NULL, ":");
             }
 
-            seed = std::stoi(inputs[1]);
+            try
+            {
+                seed = std::stoll(inputs[1]);
+            }
+            catch (const std::exception &)
+            {
+                std::cerr << "ERROR: Seed " << inputs[1] << " is not an integer in the signed 64 bit range" << std::endl;
+                delete ui;
+                return false;
+            }
             step = std::stoi(inputs[2]);
             prompt = inputs[3];
             guidance_scale = std::stof(inputs[0]);
@@ -285,10 +295,12 @@ bool processCommandLine(int argc,
         }
     }
     std::string data;
+    // Every image of a batch gets its own 32 bit seed, precomputed latents are picked by the seed modulo their count
+    std::mt19937 seedGenerator(std::random_device{}());
     while (true)
     {
         if (num_images != 1) {
-            seed = rand() % 50;
+            seed = seedGenerator();
         }
         data = client.Receive();
         std::cout << "[Server]: " << data << std::endl;
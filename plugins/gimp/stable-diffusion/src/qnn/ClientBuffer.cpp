@@ -44,7 +44,10 @@ bool ClientBuffer::freeTensorBuffer(Qnn_Tensor_t* tensor) {
     QNN_ERROR("Received nullptr for tensors");
     return false;
   }
-  if (QNN_TENSOR_GET_CLIENT_BUF(tensor).data) {
+  if (m_sameMemoryFreeTensors.erase(tensor) != 0) {
+    QNN_TENSOR_SET_CLIENT_BUF(tensor, Qnn_ClientBuffer_t({nullptr, 0u}));
+    QNN_TENSOR_SET_MEM_TYPE(tensor, QNN_TENSORMEMTYPE_UNDEFINED);
+  } else if (QNN_TENSOR_GET_CLIENT_BUF(tensor).data) {
     free(QNN_TENSOR_GET_CLIENT_BUF(tensor).data);
     QNN_TENSOR_SET_CLIENT_BUF(tensor, Qnn_ClientBuffer_t({nullptr, 0u}));
     QNN_TENSOR_SET_MEM_TYPE(tensor, QNN_TENSORMEMTYPE_UNDEFINED);
@@ -63,5 +66,6 @@ bool ClientBuffer::useSameMemory(Qnn_Tensor_t* dest, Qnn_Tensor_t* src) {
 
   QNN_TENSOR_SET_MEM_TYPE(dest, QNN_TENSOR_GET_MEM_TYPE(src));
   QNN_TENSOR_SET_CLIENT_BUF(dest, QNN_TENSOR_GET_CLIENT_BUF(src));
+  m_sameMemoryFreeTensors.insert(dest);
   return true;
 }
@@ -1470,7 +1470,9 @@ bool QnnApi::getTensorQuantStatus(const Qnn_Tensor_t* tensor, double& scale, int
     bool status = false;
     auto dataType = QNN_TENSOR_GET_DATA_TYPE(tensor);
     if (dataType == QNN_DATATYPE_UFIXED_POINT_8 ||
-            dataType == QNN_DATATYPE_UFIXED_POINT_16) {
+            dataType == QNN_DATATYPE_UFIXED_POINT_16 ||
+            dataType == QNN_DATATYPE_SFIXED_POINT_8 ||
+            dataType == QNN_DATATYPE_SFIXED_POINT_16) {
         status = true;
         scale  = QNN_TENSOR_GET_QUANT_PARAMS(tensor).scaleOffsetEncoding.scale;
         offset = QNN_TENSOR_GET_QUANT_PARAMS(tensor).scaleOffsetEncoding.offset;
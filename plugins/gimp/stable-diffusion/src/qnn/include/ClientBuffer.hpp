@@ -10,6 +10,7 @@
 #include "IBufferAlloc.hpp"
 #include "Log.hpp"
 #include <stdlib.h>
+#include <unordered_set>
 
 class ClientBuffer final : public IBufferAlloc {
  public:
@@ -39,4 +40,8 @@ class ClientBuffer final : public IBufferAlloc {
   bool useSameMemory(Qnn_Tensor_t* dest, Qnn_Tensor_t* src) override;
 
   virtual ~ClientBuffer(){};
+
+ private:
+  // Tensors given the buffer of another tensor by useSameMemory, the buffer is freed with its owner only
+  std::unordered_set<Qnn_Tensor_t*> m_sameMemoryFreeTensors;
 };
@@ -5,14 +5,224 @@
 **************************************************************************************************
 */
 
+#ifndef _SCHEDULER_HPP_
+#define _SCHEDULER_HPP_
+
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "SchedulerKernels.hpp"
+
 #ifndef float32_t
 using float32_t = float;
 #endif
 
-class DPMSolverMultistepScheduler {
+// Immutable per-step schedule built by Scheduler::setTimesteps. Steps only read from it,
+// so schedulers of the same type and configuration with the same step count can share one plan.
+struct StepPlan {
+    struct Step {
+        int32_t timestep;
+        int32_t prevTimestep;
+        // Solver order for this step, including the warm-up and lower_order_final handling
+        int32_t order;
+        // The model output conversion is a no-op, lets the unfused path skip that pass
+        bool identityConversion;
+        // Scale applied to the latent before it is fed to the UNet, 1 / sqrt(sigma^2 + 1)
+        // for the schedulers working in sigma space
+        float32_t modelInputScale = 1;
+        // Standard deviation of the fresh noise added after the update, 0 for deterministic steps
+        float32_t noiseScale = 0;
+        // Conversion and update coefficients, the guidance scale is applied per generation
+        StepCoefficients coeffs;
+        // First order jump from this step straight to the final target, used when the
+        // adaptive mode ends the generation early
+        StepCoefficients exitCoeffs;
+    };
+
+    // Scale of the initial random latent
+    float32_t initNoiseSigma = 1;
+    std::vector<Step> steps;
+};
+
+// Snapshot of a scheduler between two steps, see Scheduler::captureState
+struct SchedulerState {
+    std::shared_ptr<const StepPlan> plan;
+    int64_t latentElementCount = 0;
+    int32_t batchSize = 0;
+    int32_t finalStepIndex = 0;
+    // Scheduler specific history, e.g. the DPM-Solver++ model outputs
+    std::vector<float32_t> history;
+    int32_t historyCount = 0;
+};
+
+// Model outputs of the unconditional and conditional passes for one step, batch_size latents
+// each. Either float32 predictions, or the raw uint16 UNet outputs which the fused kernels
+// dequantize on the fly, real = quantized * scale + bias.
+struct ModelOutputs {
+    const float32_t* uncond = nullptr;
+    const float32_t* cond = nullptr;
+    const uint16_t* uncondQuantized = nullptr;
+    const uint16_t* condQuantized = nullptr;
+    float32_t scale = 1;
+    float32_t bias = 0;
+
+    bool quantized() const { return nullptr != uncondQuantized; }
+};
+
+// Quantized copy of the updated latents written by the step, batch_size latents back to back,
+// quantized = clamp(latent * multiplier + bias). Lets the step hand its result straight to the
+// quantized input of the model that reads it next.
+struct QuantizedLatents {
+    uint16_t* data = nullptr;
+    float32_t multiplier = 1;
+    float32_t bias = 0;
+};
+
+// Interface shared by every scheduler. The schedulers precompute a StepPlan per step count and
+// run each step through the SchedulerKernels, so the callers only deal with step indices.
+class Scheduler {
+public:
+    virtual ~Scheduler() = default;
+
+    void setGuidanceScale(double guidanceScale) { m_GuidanceScale = static_cast<float32_t>(guidanceScale); };
+
+    // Sets the NHWC latent shape the scheduler operates on, by default 64x64x4. This reallocates
+    // the scheduler buffers and resets the history, so it must be called before a generation starts.
+    bool setLatentShape(int32_t height, int32_t width, int32_t channel);
+    int64_t getLatentElementCount() const { return m_LatentElementCount; }
+
+    // Number of independent latents advanced together by stepBatch, 1 by default. This
+    // reallocates the scheduler buffers and resets the history like setLatentShape.
+    bool setBatchSize(int32_t batch_size);
+    int32_t getBatchSize() const { return m_BatchSize; }
+
+    // Overrides the SIMD kernel set picked at construction, e.g. to run the scalar reference path
+    void setKernelIsa(CpuFeatures::Isa isa);
+    CpuFeatures::Isa getKernelIsa() const { return m_KernelIsa; }
+
+    // Fused mode streams the latent once per step through guidance, conversion and the
+    // solver update. The unfused mode keeps one kernel per stage as a reference path.
+    void setFusedStep(bool fused) { m_FusedStep = fused; }
+    bool getFusedStep() const { return m_FusedStep; }
+
+    // Spacing of the inference timesteps over the train timesteps, one of "linspace", "leading",
+    // "trailing", "karras" or "exponential". The sigma spacings are snapped to whole timesteps so
+    // that they keep matching the UNet time embeddings. Takes effect with the next setTimesteps.
+    bool setTimestepSpacing(const std::string& timestep_spacing);
+
+    // Builds (or reuses) the step plan for the given step count and resets the history
+    bool setTimesteps(int32_t num_inference_steps);
+
+    // Builds the step plan for the given step count without touching the scheduler state
+    virtual std::shared_ptr<const StepPlan> buildStepPlan(int32_t num_inference_steps) const = 0;
+
+    // Shares a plan built by a scheduler with the same configuration, resets the solver history
+    void setStepPlan(std::shared_ptr<const StepPlan> plan);
+    std::shared_ptr<const StepPlan> getStepPlan() const { return m_StepPlan; }
+
+    // Accessors of the current plan, only valid after setTimesteps succeeded
+    int32_t getNumInferenceSteps() const { return static_cast<int32_t>(m_StepPlan->steps.size()); }
+    int32_t getTimestep(int32_t step_index) const { return m_StepPlan->steps[step_index].timestep; }
+    float32_t getModelInputScale(int32_t step_index) const { return m_StepPlan->steps[step_index].modelInputScale; }
+    float32_t getInitNoiseSigma() const { return m_StepPlan->initNoiseSigma; }
+
+    // Seeds the noise of the stochastic schedulers, a no-op for the deterministic ones
+    virtual void setNoiseSeed(uint64_t seed) {}
+
+    // Adaptive mode, 0 (default) disables it. Once a step changes the latent by less than the
+    // relative tolerance (L2 norm), the next step jumps straight to the final target and ends
+    // the generation.
+    void setAdaptiveTolerance(float32_t tolerance) { m_AdaptiveTolerance = tolerance; }
+    float32_t getAdaptiveTolerance() const { return m_AdaptiveTolerance; }
+
+    // Index of the step that finishes the current generation, the last plan step unless the
+    // adaptive mode converged earlier
+    int32_t getFinalStepIndex() const { return m_FinalStepIndex; }
+
+    // Copies the solver state reached by the steps run so far, so that several generations can
+    // continue from it with e.g. other guidance scales, prompts or noise seeds. restoreState
+    // needs the same latent shape and batch size, it also restores the step plan.
+    bool captureState(SchedulerState& state) const;
+    bool restoreState(const SchedulerState& state);
+
+    // Runs step `step_index` of the current plan, steps have to run in order from 0.
+    // model_output holds the uncond and cond predictions back to back.
+    // Only valid with a batch size of 1, see stepBatch otherwise.
+    bool step(void* model_output, int32_t step_index, void* prev_output, void* curr_output);
+
+    // Runs step `step_index` for every latent of the batch with one set of coefficients.
+    // Buffers are laid out as arrays of latents: prev_output and curr_output hold
+    // batch_size latents back to back, model_output holds the batch_size uncond
+    // predictions followed by the batch_size cond predictions.
+    bool stepBatch(void* model_output, int32_t step_index, void* prev_output, void* curr_output);
+
+    // stepBatch on the raw uint16 outputs of the unconditional and conditional UNet passes,
+    // batch_size latents each, with the QNN encoding real = (quantized + offset) * scale. The
+    // fused step dequantizes while it blends, so no float copy of the model outputs is made.
+    // When quantized_latents is given, the updated latents are also quantized into it.
+    bool stepQuantized(const uint16_t* uncond_output, const uint16_t* cond_output, double scale, int32_t offset,
+                       int32_t step_index, void* prev_output, void* curr_output,
+                       const QuantizedLatents* quantized_latents = nullptr);
+
+protected:
+    enum class TimestepSpacing { LINSPACE, LEADING, TRAILING, KARRAS, EXPONENTIAL };
+
+    Scheduler();
+
+    // Betas of the given schedule, trained_betas take precedence when not empty
+    static std::vector<float32_t> makeBetas(int32_t num_train_timesteps, double beta_start, double beta_end,
+                                            const std::string& beta_schedule, const std::vector<float32_t>& trained_betas);
+
+    // Reallocates the per-latent buffers for the new element count and batch size
+    virtual bool resizeBuffers(int64_t latent_element_count, int32_t batch_size) = 0;
+
+    // Forgets the model outputs of the previous steps
+    virtual void resetHistory();
+
+    // Copy the scheduler specific history to and from a snapshot
+    virtual void saveHistory(SchedulerState& state) const {}
+    virtual bool loadHistory(const SchedulerState& state) { return true; }
+
+    // Runs the update of step_index for the whole batch, with the plan step's exitCoeffs
+    // instead of its coefficients when final_jump is set
+    // The model outputs are only quantized in fused mode. quantized_latents.data is nullptr when
+    // no quantized copy of the latents is requested.
+    virtual bool runStep(const ModelOutputs& model_output, int32_t step_index, bool final_jump,
+                         void* prev_output, void* curr_output, const QuantizedLatents& quantized_latents) = 0;
+
+    // Checks the step, runs it and tracks the adaptive mode, shared by stepBatch and stepQuantized
+    bool advance(const ModelOutputs& model_output, int32_t step_index, void* prev_output, void* curr_output,
+                 const QuantizedLatents& quantized_latents);
+
+    // Checks the plan, the buffers and the step index before running a step
+    bool checkStep(int32_t step_index) const;
+
+    // num_points strictly decreasing train timesteps following m_TimestepSpacing,
+    // empty when the train timesteps can't hold that many points
+    std::vector<int32_t> spacedTimesteps(int32_t num_points) const;
+
+    std::vector<float32_t> m_AlphasCumprod;
+    int32_t m_NumTrainTimesteps;
+    TimestepSpacing m_TimestepSpacing;
+    // Shift of the "leading" spacing
+    int32_t m_StepsOffset;
+    std::shared_ptr<const StepPlan> m_StepPlan;
+    int64_t m_LatentElementCount;
+    int32_t m_BatchSize;
+    float32_t m_GuidanceScale;
+    CpuFeatures::Isa m_KernelIsa;
+    const SchedulerKernels* m_Kernels;
+    bool m_FusedStep;
+    float32_t m_AdaptiveTolerance;
+    int32_t m_FinalStepIndex;
+    // Input latents of the current step, kept to measure the change in adaptive mode
+    std::vector<float32_t> m_PrevLatents;
+    // Float copy of quantized model outputs for the unfused reference path
+    std::vector<float32_t> m_DequantizedOutputs;
+}; // Scheduler class
+
+class DPMSolverMultistepScheduler : public Scheduler {
 public:
     
     ~DPMSolverMultistepScheduler();
@@ -26,45 +236,49 @@ public:
                                 double sample_max_value=1.0, std::string algorithm_type="dpmsolver++",
                                 std::string solver_type="midpoint", bool lower_order_final=true);
 
-    
-    void setGuidanceScale(double guidanceScale) { m_GuidanceScale = static_cast<float32_t>(guidanceScale); };
-    
-    
-    void setTimesteps(int32_t num_inference_steps);
+    std::shared_ptr<const StepPlan> buildStepPlan(int32_t num_inference_steps) const override;
 
-    
-    bool step(void* model_output, int32_t timestep, void* prev_output, void* curr_output);
+protected:
+    bool resizeBuffers(int64_t latent_element_count, int32_t batch_size) override;
+
+    void resetHistory() override;
+
+    void saveHistory(SchedulerState& state) const override;
+    bool loadHistory(const SchedulerState& state) override;
+
+    bool runStep(const ModelOutputs& model_output, int32_t step_index, bool final_jump,
+                 void* prev_output, void* curr_output, const QuantizedLatents& quantized_latents) override;
 
 private:
+    enum class AlgorithmType { DPMSOLVER_PLUS_PLUS, DPMSOLVER, INVALID };
+    enum class PredictionType { EPSILON, SAMPLE, V_PREDICTION, INVALID };
+    enum class SolverType { MIDPOINT, HEUN, INVALID };
+
     std::vector<float32_t> m_Betas;
     std::vector<float32_t> m_Alphas;
-    std::vector<float32_t> m_AlphasCumprod;
     std::vector<float32_t> m_Alpha_t;
     std::vector<float32_t> m_Sigma_t;
     std::vector<float32_t> m_Lambda_t;
-    float32_t m_InitNoiseSigma;
-    std::vector<int32_t> m_Timesteps;
+    // Each history slot holds the converted model output of every latent in the batch
     std::vector<void*> m_ModelOutputs;
     int32_t m_LowerOrderNums;
-    int32_t m_NumInferenceSteps;
-    int32_t m_NumTrainTimesteps;
-    float32_t m_GuidanceScale;
-    std::string m_AlgorithmType;
-    std::string m_PredictionType;
-    std::string m_SolverType;
+    AlgorithmType m_AlgorithmType;
+    PredictionType m_PredictionType;
+    SolverType m_SolverType;
     int32_t m_SolverOrder;
     bool m_Thresholding;
     bool m_LowerOrderFinal;
 
-    bool convertModelOutput(void* model_data, int32_t timestep, void* sample_data);
+    bool convertModelOutputCoefficients(int32_t timestep, StepCoefficients& coeffs, bool& identity) const;
 
-    void dpmSolverFirstOrderUpdate(const std::vector<int32_t>& timestep,
-                                   int32_t prev_timestep, void* sample_data, void* curr_output);
+    void dpmSolverFirstOrderCoefficients(int32_t s0, int32_t prev_timestep, StepCoefficients& coeffs) const;
 
-    void dpmSolverSecondOrderUpdate(const std::vector<int32_t>& timestep,
-                                    int32_t prev_timestep, void* sample_data, void* curr_output);
+    void dpmSolverSecondOrderCoefficients(int32_t s0, int32_t s1,
+                                          int32_t prev_timestep, StepCoefficients& coeffs) const;
     
-    void dpmSolverThirdOrderUpdate(const std::vector<int32_t>& timestep,
-                                   int32_t prev_timestep, void* sample_data, void* curr_output);
+    void dpmSolverThirdOrderCoefficients(int32_t s0, int32_t s1, int32_t s2,
+                                         int32_t prev_timestep, StepCoefficients& coeffs) const;
 
 }; // DPMSolverMultistepScheduler class
+
+#endif
@@ -0,0 +1,19 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#ifndef _SCHEDULERFACTORY_HPP_
+#define _SCHEDULERFACTORY_HPP_
+
+#include "Scheduler.hpp"
+
+// Creates the scheduler named by scheduler_type, one of "dpmsolver++", "euler", "euler_ancestral",
+// "ddim" or "lcm". trained_lambdas are only used by DPM-Solver++. Returns nullptr for an unknown
+// type, the caller owns the returned scheduler.
+Scheduler* createScheduler(const std::string& scheduler_type, int32_t num_train_timesteps,
+                           double beta_start, double beta_end, const std::string& beta_schedule,
+                           const std::vector<float32_t>& trained_betas,
+                           const std::vector<float32_t>& trained_lambdas);
+
+#endif
@@ -0,0 +1,111 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#ifndef _SCHEDULERKERNELS_HPP_
+#define _SCHEDULERKERNELS_HPP_
+
+#include <cstdint>
+
+#include "CpuFeatures.hpp"
+
+#ifndef float32_t
+using float32_t = float;
+#endif
+
+// Latent element counts (NHWC, 4 channels) with dedicated fixed-size kernel tables,
+// i.e. 512x512 and 768x768 output images
+constexpr int64_t kLatentCount64x64 = 1 * 64 * 64 * 4;
+constexpr int64_t kLatentCount96x96 = 1 * 96 * 96 * 4;
+
+// Scalar coefficients of one fused scheduler step
+struct StepCoefficients {
+    // Dequantization of uint16 model outputs, real = quantized * dequant_scale + dequant_bias
+    float32_t dequant_scale = 1, dequant_bias = 0;
+    // Quantization of the updated latent, quantized = clamp(x * quant_multiplier + quant_bias)
+    float32_t quant_multiplier = 1, quant_bias = 0;
+    // Classifier-free guidance scale
+    float32_t guidance = 1;
+    // Model output conversion, model_output = (p * sample + q * model_output) * r
+    float32_t p = 0, q = 1, r = 1;
+    // Multistep update weights
+    float32_t w0 = 0, w1 = 0, w2 = 0, w3 = 0;
+    float32_t inv_r0 = 0, inv_r1 = 0, r0_over_r01 = 0, inv_r01 = 0;
+};
+
+// Element-wise kernels used by the DPM-Solver++ scheduler. Every ISA variant
+// implements the same arithmetic as the scalar reference, so results only
+// differ by FMA contraction.
+struct SchedulerKernels {
+    // out = uncond + scale * (cond - uncond)
+    void (*guidance)(float32_t* out, const float32_t* uncond, const float32_t* cond,
+                     float32_t scale, int64_t n);
+
+    // model = (p * sample + q * model) * r
+    void (*convert)(float32_t* model, const float32_t* sample,
+                    float32_t p, float32_t q, float32_t r, int64_t n);
+
+    // x = w0 * sample - w1 * m0
+    void (*firstOrder)(float32_t* x, const float32_t* sample, const float32_t* m0,
+                       float32_t w0, float32_t w1, int64_t n);
+
+    // x = w0 * sample - w1 * m0 - w2 * D1, D1 = (m0 - m1) / r0
+    void (*secondOrder)(float32_t* x, const float32_t* sample, const float32_t* m0, const float32_t* m1,
+                        float32_t w0, float32_t w1, float32_t w2, float32_t inv_r0, int64_t n);
+
+    // x = w0 * sample - w1 * m0 - w2 * D1 - w3 * D2
+    void (*thirdOrder)(float32_t* x, const float32_t* sample,
+                       const float32_t* m0, const float32_t* m1, const float32_t* m2,
+                       float32_t w0, float32_t w1, float32_t w2, float32_t w3,
+                       float32_t inv_r0, float32_t inv_r1, float32_t r0_over_r01, float32_t inv_r01,
+                       int64_t n);
+
+    // Single pass versions of guidance + convert + update of the given order. The converted
+    // model output is stored into m0 so that it stays in the history for the next step.
+    void (*fusedFirstOrder)(float32_t* x, float32_t* m0, const float32_t* sample,
+                            const float32_t* uncond, const float32_t* cond,
+                            const StepCoefficients& c, int64_t n);
+
+    void (*fusedSecondOrder)(float32_t* x, float32_t* m0, const float32_t* sample,
+                             const float32_t* uncond, const float32_t* cond, const float32_t* m1,
+                             const StepCoefficients& c, int64_t n);
+
+    void (*fusedThirdOrder)(float32_t* x, float32_t* m0, const float32_t* sample,
+                            const float32_t* uncond, const float32_t* cond,
+                            const float32_t* m1, const float32_t* m2,
+                            const StepCoefficients& c, int64_t n);
+
+    // Same as the fused kernels above, reading the raw uint16 UNet outputs and dequantizing
+    // them with c.dequant_scale and c.dequant_bias before the guidance blend. Unless xq is
+    // nullptr, the updated latent is also quantized into xq with c.quant_multiplier and
+    // c.quant_bias in the same pass.
+    void (*fusedFirstOrderQuantized)(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                     const uint16_t* uncond, const uint16_t* cond,
+                                     const StepCoefficients& c, int64_t n);
+
+    void (*fusedSecondOrderQuantized)(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                      const uint16_t* uncond, const uint16_t* cond, const float32_t* m1,
+                                      const StepCoefficients& c, int64_t n);
+
+    void (*fusedThirdOrderQuantized)(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                     const uint16_t* uncond, const uint16_t* cond,
+                                     const float32_t* m1, const float32_t* m2,
+                                     const StepCoefficients& c, int64_t n);
+
+    // q = clamp(x * multiplier + bias) to [0, 65535], truncated
+    void (*quantize)(uint16_t* q, const float32_t* x, float32_t multiplier, float32_t bias, int64_t n);
+};
+
+// Returns the kernel table for the given ISA. Falls back to the scalar table
+// when the ISA was not compiled in for this target. When n matches one of the
+// fixed latent sizes the returned kernels are specialized for that size and
+// must only be called with exactly n elements.
+const SchedulerKernels& getSchedulerKernels(CpuFeatures::Isa isa, int64_t n = 0);
+
+// Runs every kernel of the given ISA and the scalar reference on the same
+// synthetic data of n elements and checks the results agree within the
+// relative tolerance.
+bool verifySchedulerKernels(CpuFeatures::Isa isa, int64_t n = 4096, float32_t tolerance = 1e-5f);
+
+#endif
@@ -0,0 +1,91 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#ifndef _SINGLESTEPSCHEDULER_HPP_
+#define _SINGLESTEPSCHEDULER_HPP_
+
+#include <random>
+
+#include "Scheduler.hpp"
+
+// Base of the schedulers whose update only depends on the current model output. Every step
+// converts the guided model output to the denoised sample x0 and computes
+//      x = w0 * sample - w1 * x0 + noiseScale * noise
+// so the subclasses only build the plan and the fused first order kernel does the rest.
+class SingleStepScheduler : public Scheduler {
+public:
+    void setNoiseSeed(uint64_t seed) override { m_NoiseGenerator.seed(seed); }
+
+protected:
+    SingleStepScheduler(int32_t num_train_timesteps, double beta_start, double beta_end,
+                        const std::string& beta_schedule, const std::vector<float32_t>& trained_betas,
+                        const std::string& prediction_type);
+
+    bool resizeBuffers(int64_t latent_element_count, int32_t batch_size) override;
+
+    bool runStep(const ModelOutputs& model_output, int32_t step_index, bool final_jump,
+                 void* prev_output, void* curr_output, const QuantizedLatents& quantized_latents) override;
+
+    // Conversion of the model output at `timestep` to x0, for a latent holding
+    // sample_scale times the variance preserving sample
+    bool dataPredictionCoefficients(int32_t timestep, double sample_scale,
+                                    StepCoefficients& coeffs, bool& identity) const;
+
+private:
+    enum class PredictionType { EPSILON, SAMPLE, V_PREDICTION, INVALID };
+
+    PredictionType m_PredictionType;
+    // x0 of every latent in the batch, only read back by the unfused path
+    std::vector<float32_t> m_DataPrediction;
+    std::vector<float32_t> m_Noise;
+    std::mt19937_64 m_NoiseGenerator;
+    std::normal_distribution<float32_t> m_NormalDistribution;
+}; // SingleStepScheduler class
+
+// Euler method in sigma space (k-diffusion), optionally ancestral with fresh noise every step
+class EulerDiscreteScheduler : public SingleStepScheduler {
+public:
+    EulerDiscreteScheduler(int32_t num_train_timesteps=1000, double beta_start=0.0001,
+                           double beta_end=0.02, std::string beta_schedule="linear",
+                           std::vector<float32_t> trained_betas={}, std::string prediction_type="epsilon",
+                           bool ancestral=false);
+
+    std::shared_ptr<const StepPlan> buildStepPlan(int32_t num_inference_steps) const override;
+
+private:
+    bool m_Ancestral;
+}; // EulerDiscreteScheduler class
+
+// Deterministic DDIM (eta = 0), with "leading" timestep spacing by default
+class DDIMScheduler : public SingleStepScheduler {
+public:
+    DDIMScheduler(int32_t num_train_timesteps=1000, double beta_start=0.0001,
+                  double beta_end=0.02, std::string beta_schedule="linear",
+                  std::vector<float32_t> trained_betas={}, std::string prediction_type="epsilon",
+                  int32_t steps_offset=1, bool set_alpha_to_one=false);
+
+    std::shared_ptr<const StepPlan> buildStepPlan(int32_t num_inference_steps) const override;
+
+private:
+    float32_t m_FinalAlphaCumprod;
+}; // DDIMScheduler class
+
+// Latent consistency model multistep sampling, meant for LCM distilled UNets running 4-8 steps.
+// The timesteps always come from the distillation schedule, the spacing setting is ignored.
+class LCMScheduler : public SingleStepScheduler {
+public:
+    LCMScheduler(int32_t num_train_timesteps=1000, double beta_start=0.00085,
+                 double beta_end=0.012, std::string beta_schedule="scaled_linear",
+                 std::vector<float32_t> trained_betas={}, std::string prediction_type="epsilon",
+                 int32_t original_inference_steps=50, double timestep_scaling=10.0);
+
+    std::shared_ptr<const StepPlan> buildStepPlan(int32_t num_inference_steps) const override;
+
+private:
+    int32_t m_OriginalInferenceSteps;
+    double m_TimestepScaling;
+}; // LCMScheduler class
+
+#endif
@@ -4,12 +4,17 @@
 // ---------------------------------------------------------------------
 
 #include "Scheduler.hpp"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
-#define INPUT_WIDTH 64
-#define INPUT_HEIGHT 64
-#define INPUT_CHANNEL 4
-#define TOTAL_LENGTH INPUT_WIDTH*INPUT_HEIGHT*INPUT_CHANNEL
+// rho of the Karras et al. (2022) sigma schedule
+#define KARRAS_RHO 7.0
+
+// Latent shape used until setLatentShape() is called, SD 1.5 at 512x512
+#define DEFAULT_LATENT_HEIGHT 64
+#define DEFAULT_LATENT_WIDTH 64
+#define DEFAULT_LATENT_CHANNEL 4
 
 #ifdef BUILD_RELEASE
 #define MY_LOGV(format, ...)
@@ -29,10 +34,6 @@
 #endif
 #endif
 
-inline float32_t torch_exp(float32_t x) {
-    return std::pow(2.71828185, x);
-}
-
 inline double alphaBar(double timestep) {
     const double pi = std::atan(static_cast<double>(1)) * 4;
     return std::pow(std::cos((timestep + 0.008) / 1.008 * pi / 2), 2);
@@ -62,6 +63,352 @@ std::vector<float32_t> betasForAlphaBar(int64_t num_diffusion_timesteps, double
     return betas;
 }
 
+Scheduler::Scheduler() {
+    m_LatentElementCount = 0;
+    m_BatchSize = 1;
+    m_GuidanceScale = 1;
+    m_FusedStep = true;
+    m_NumTrainTimesteps = 0;
+    m_TimestepSpacing = TimestepSpacing::LINSPACE;
+    m_StepsOffset = 1;
+    m_AdaptiveTolerance = 0;
+    m_FinalStepIndex = 0;
+    m_KernelIsa = CpuFeatures::detectIsa();
+    m_Kernels = &getSchedulerKernels(m_KernelIsa);
+    MY_LOGD("Using %s scheduler kernels", CpuFeatures::isaName(m_KernelIsa));
+}
+
+std::vector<float32_t> Scheduler::makeBetas(int32_t num_train_timesteps, double beta_start, double beta_end,
+                                            const std::string& beta_schedule, const std::vector<float32_t>& trained_betas) {
+    std::vector<float32_t> betas;
+    if (!trained_betas.empty()) {
+        betas = trained_betas;
+    } else if (beta_schedule == "linear") {
+        betas = linspace(beta_start, beta_end, num_train_timesteps);
+    } else if (beta_schedule == "scaled_linear") {
+        betas = linspace(std::sqrt(beta_start), std::sqrt(beta_end), num_train_timesteps);
+        for (size_t i = 0; i < betas.size(); ++i) {
+            betas[i] = betas[i] * betas[i];
+        }
+    } else if (beta_schedule == "squaredcos_cap_v2") {
+        betas = betasForAlphaBar(num_train_timesteps);
+    } else {
+        MY_LOGE("beta_schedule given as %s must be one of `linear`, `scaled_linear`, or `squaredcos_cap_v2`.",
+                beta_schedule.c_str());
+    }
+    return betas;
+}
+
+bool Scheduler::setLatentShape(int32_t height, int32_t width, int32_t channel) {
+    if (height <= 0 || width <= 0 || channel <= 0) {
+        MY_LOGE("Invalid latent shape %dx%dx%d", height, width, channel);
+        return false;
+    }
+
+    const int64_t latent_element_count = static_cast<int64_t>(height) * width * channel;
+    if (true != resizeBuffers(latent_element_count, m_BatchSize)) {
+        m_LatentElementCount = 0;
+        return false;
+    }
+    m_LatentElementCount = latent_element_count;
+
+    // The history no longer matches the new shape
+    resetHistory();
+
+    // Re-select the kernels, the common latent sizes have their own fixed-size tables
+    setKernelIsa(m_KernelIsa);
+    return true;
+}
+
+bool Scheduler::setBatchSize(int32_t batch_size) {
+    if (batch_size <= 0) {
+        MY_LOGE("Invalid batch size %d", batch_size);
+        return false;
+    }
+    if (0 == m_LatentElementCount) {
+        MY_LOGE("No latent shape, setLatentShape failed");
+        return false;
+    }
+    if (true != resizeBuffers(m_LatentElementCount, batch_size)) {
+        m_LatentElementCount = 0;
+        return false;
+    }
+    m_BatchSize = batch_size;
+    resetHistory();
+    return true;
+}
+
+void Scheduler::setKernelIsa(CpuFeatures::Isa isa) {
+    // Only trust a SIMD kernel set once it agrees with the scalar reference
+    if (isa != CpuFeatures::Isa::SCALAR && !verifySchedulerKernels(isa, m_LatentElementCount)) {
+        MY_LOGE("%s scheduler kernels don't match the scalar reference, falling back to scalar",
+                CpuFeatures::isaName(isa));
+        isa = CpuFeatures::Isa::SCALAR;
+    }
+    // setLatentShape re-selects the tables on every shape, only a change of ISA is worth a log
+    if (isa != m_KernelIsa) {
+        MY_LOGD("Using %s scheduler kernels", CpuFeatures::isaName(isa));
+    }
+    m_KernelIsa = isa;
+    m_Kernels = &getSchedulerKernels(isa, m_LatentElementCount);
+}
+
+bool Scheduler::setTimestepSpacing(const std::string& timestep_spacing) {
+    TimestepSpacing spacing;
+    if (timestep_spacing == "linspace") {
+        spacing = TimestepSpacing::LINSPACE;
+    } else if (timestep_spacing == "leading") {
+        spacing = TimestepSpacing::LEADING;
+    } else if (timestep_spacing == "trailing") {
+        spacing = TimestepSpacing::TRAILING;
+    } else if (timestep_spacing == "karras") {
+        spacing = TimestepSpacing::KARRAS;
+    } else if (timestep_spacing == "exponential") {
+        spacing = TimestepSpacing::EXPONENTIAL;
+    } else {
+        MY_LOGE("timestep_spacing given as %s must be one of `linspace`, `leading`, `trailing`, `karras`, or `exponential`.",
+                timestep_spacing.c_str());
+        return false;
+    }
+
+    // The cached plan was built for the previous spacing
+    if (spacing != m_TimestepSpacing) {
+        m_TimestepSpacing = spacing;
+        m_StepPlan = nullptr;
+    }
+    return true;
+}
+
+std::vector<int32_t> Scheduler::spacedTimesteps(int32_t num_points) const {
+    const int32_t num_train_timesteps = m_NumTrainTimesteps;
+    if (num_points <= 0 || num_points > num_train_timesteps || m_AlphasCumprod.size() < static_cast<size_t>(num_train_timesteps)) {
+        MY_LOGE("Can't space %d timesteps over %d train timesteps", num_points, num_train_timesteps);
+        return {};
+    }
+
+    std::vector<int32_t> timesteps(num_points);
+    if (m_TimestepSpacing == TimestepSpacing::LINSPACE) {
+        auto linear = linspace(0, num_train_timesteps - 1, num_points);
+        for (int32_t i = 0; i < num_points; ++i) {
+            timesteps[i] = static_cast<int32_t>(std::round(linear[num_points - 1 - i]));
+        }
+    } else if (m_TimestepSpacing == TimestepSpacing::LEADING) {
+        const int32_t step_ratio = num_train_timesteps / num_points;
+        for (int32_t i = 0; i < num_points; ++i) {
+            timesteps[i] = (num_points - 1 - i) * step_ratio + m_StepsOffset;
+        }
+    } else if (m_TimestepSpacing == TimestepSpacing::TRAILING) {
+        const double step_ratio = static_cast<double>(num_train_timesteps) / num_points;
+        for (int32_t i = 0; i < num_points; ++i) {
+            timesteps[i] = static_cast<int32_t>(std::round(num_train_timesteps - i * step_ratio)) - 1;
+        }
+    } else {
+        // Sigma spacings are built between the extreme train sigmas and mapped back to timesteps
+        // by interpolating log(sigma), which grows monotonically with the timestep
+        std::vector<double> log_sigmas(num_train_timesteps);
+        for (int32_t t = 0; t < num_train_timesteps; ++t) {
+            log_sigmas[t] = 0.5 * std::log((1.0 - m_AlphasCumprod[t]) / m_AlphasCumprod[t]);
+        }
+        const double log_sigma_min = log_sigmas.front();
+        const double log_sigma_max = log_sigmas.back();
+
+        for (int32_t i = 0; i < num_points; ++i) {
+            double ramp = (num_points > 1) ? static_cast<double>(i) / (num_points - 1) : 0.0;
+            double log_sigma;
+            if (m_TimestepSpacing == TimestepSpacing::KARRAS) {
+                double max_inv_rho = std::exp(log_sigma_max / KARRAS_RHO);
+                double min_inv_rho = std::exp(log_sigma_min / KARRAS_RHO);
+                log_sigma = KARRAS_RHO * std::log(max_inv_rho + ramp * (min_inv_rho - max_inv_rho));
+            } else {
+                log_sigma = log_sigma_max + ramp * (log_sigma_min - log_sigma_max);
+            }
+
+            auto upper = std::lower_bound(log_sigmas.begin(), log_sigmas.end(), log_sigma);
+            if (upper == log_sigmas.begin()) {
+                timesteps[i] = 0;
+            } else if (upper == log_sigmas.end()) {
+                timesteps[i] = num_train_timesteps - 1;
+            } else {
+                int32_t high = static_cast<int32_t>(upper - log_sigmas.begin());
+                double w = (log_sigma - log_sigmas[high - 1]) / (log_sigmas[high] - log_sigmas[high - 1]);
+                timesteps[i] = static_cast<int32_t>(std::round(high - 1 + w));
+            }
+        }
+    }
+
+    // Snapping to whole timesteps can merge the dense low noise end of a schedule, keep the
+    // sequence strictly decreasing so that no solver step has a zero step size
+    timesteps[num_points - 1] = std::max(std::min(timesteps[num_points - 1], num_train_timesteps - num_points), 0);
+    for (int32_t i = num_points - 2; i >= 0; --i) {
+        timesteps[i] = std::min(std::max(timesteps[i], timesteps[i + 1] + 1), num_train_timesteps - 1 - i);
+    }
+    return timesteps;
+}
+
+bool Scheduler::setTimesteps(int32_t num_inference_steps) {
+    // The plan only depends on the step count, keep it when the count didn't change
+    if (nullptr == m_StepPlan || m_StepPlan->steps.size() != static_cast<size_t>(num_inference_steps)) {
+        m_StepPlan = buildStepPlan(num_inference_steps);
+    }
+
+    resetHistory();
+    return nullptr != m_StepPlan;
+}
+
+void Scheduler::setStepPlan(std::shared_ptr<const StepPlan> plan) {
+    m_StepPlan = std::move(plan);
+    resetHistory();
+}
+
+bool Scheduler::step(void* model_output, int32_t step_index, void* prev_output, void* curr_output) {
+    if (m_BatchSize != 1) {
+        MY_LOGE("step expects a batch size of 1, use stepBatch for %d latents", m_BatchSize);
+        return false;
+    }
+    return stepBatch(model_output, step_index, prev_output, curr_output);
+}
+
+bool Scheduler::stepBatch(void* model_output, int32_t step_index, void* prev_output, void* curr_output) {
+    ModelOutputs outputs;
+    outputs.uncond = (const float32_t*) model_output;
+    outputs.cond   = (const float32_t*) model_output + m_LatentElementCount * m_BatchSize;
+    return advance(outputs, step_index, prev_output, curr_output, QuantizedLatents());
+}
+
+bool Scheduler::stepQuantized(const uint16_t* uncond_output, const uint16_t* cond_output, double scale, int32_t offset,
+                              int32_t step_index, void* prev_output, void* curr_output,
+                              const QuantizedLatents* quantized_latents) {
+    if (nullptr == uncond_output || nullptr == cond_output) {
+        MY_LOGE("stepQuantized needs both model outputs");
+        return false;
+    }
+    const auto dequant_scale = static_cast<float32_t>(scale);
+    const auto dequant_bias  = static_cast<float32_t>(offset * scale);
+    const QuantizedLatents& quantized = (nullptr != quantized_latents) ? *quantized_latents : QuantizedLatents();
+
+    ModelOutputs outputs;
+    if (!m_FusedStep) {
+        // The reference path keeps one pass per stage, dequantization included
+        const int64_t element_count = m_LatentElementCount * m_BatchSize;
+        m_DequantizedOutputs.resize(2 * element_count);
+        for (int64_t i = 0; i < element_count; ++i) {
+            m_DequantizedOutputs[i] = uncond_output[i] * dequant_scale + dequant_bias;
+            m_DequantizedOutputs[element_count + i] = cond_output[i] * dequant_scale + dequant_bias;
+        }
+        outputs.uncond = m_DequantizedOutputs.data();
+        outputs.cond   = m_DequantizedOutputs.data() + element_count;
+        return advance(outputs, step_index, prev_output, curr_output, quantized);
+    }
+
+    outputs.uncondQuantized = uncond_output;
+    outputs.condQuantized   = cond_output;
+    outputs.scale = dequant_scale;
+    outputs.bias  = dequant_bias;
+    return advance(outputs, step_index, prev_output, curr_output, quantized);
+}
+
+bool Scheduler::advance(const ModelOutputs& model_output, int32_t step_index, void* prev_output, void* curr_output,
+                        const QuantizedLatents& quantized_latents) {
+    if (true != checkStep(step_index)) {
+        return false;
+    }
+    if (step_index > m_FinalStepIndex) {
+        MY_LOGE("step %d is past the final step %d of this generation", step_index, m_FinalStepIndex);
+        return false;
+    }
+
+    const bool final_jump = (step_index == m_FinalStepIndex) &&
+                            (step_index != static_cast<int32_t>(m_StepPlan->steps.size()) - 1);
+    const bool track_change = (m_AdaptiveTolerance > 0) && (step_index < m_FinalStepIndex);
+
+    // The update may run in place, keep the input latents to measure the change
+    const int64_t element_count = m_LatentElementCount * m_BatchSize;
+    if (track_change) {
+        m_PrevLatents.resize(element_count);
+        std::memcpy(m_PrevLatents.data(), prev_output, element_count * sizeof(float32_t));
+    }
+
+    if (true != runStep(model_output, step_index, final_jump, prev_output, curr_output, quantized_latents)) {
+        return false;
+    }
+
+    if (track_change) {
+        // One reduction pass per step, negligible next to the UNet
+        auto curr = (const float32_t*) curr_output;
+        double diff_norm = 0.0;
+        double prev_norm = 0.0;
+        for (int64_t i = 0; i < element_count; ++i) {
+            double diff = static_cast<double>(curr[i]) - m_PrevLatents[i];
+            diff_norm += diff * diff;
+            prev_norm += static_cast<double>(m_PrevLatents[i]) * m_PrevLatents[i];
+        }
+        double relative_change = std::sqrt(diff_norm / std::max(prev_norm, 1e-30));
+        if (relative_change < m_AdaptiveTolerance) {
+            m_FinalStepIndex = step_index + 1;
+            MY_LOGD("Latent change %f below %f at step %d, finishing at step %d of %zu",
+                    relative_change, m_AdaptiveTolerance, step_index, m_FinalStepIndex, m_StepPlan->steps.size());
+        }
+    }
+
+    return true;
+}
+
+bool Scheduler::captureState(SchedulerState& state) const {
+    if (nullptr == m_StepPlan || 0 == m_LatentElementCount) {
+        MY_LOGE("No generation to capture, setTimesteps and setLatentShape must succeed first");
+        return false;
+    }
+
+    state.plan = m_StepPlan;
+    state.latentElementCount = m_LatentElementCount;
+    state.batchSize = m_BatchSize;
+    state.finalStepIndex = m_FinalStepIndex;
+    state.history.clear();
+    state.historyCount = 0;
+    saveHistory(state);
+    return true;
+}
+
+bool Scheduler::restoreState(const SchedulerState& state) {
+    if (nullptr == state.plan) {
+        MY_LOGE("The scheduler state holds no step plan");
+        return false;
+    }
+    if (state.latentElementCount != m_LatentElementCount || state.batchSize != m_BatchSize) {
+        MY_LOGE("The scheduler state of %lld x %d elements doesn't match the %lld x %d scheduler",
+                static_cast<long long>(state.latentElementCount), state.batchSize,
+                static_cast<long long>(m_LatentElementCount), m_BatchSize);
+        return false;
+    }
+
+    if (true != loadHistory(state)) {
+        return false;
+    }
+    m_StepPlan = state.plan;
+    m_FinalStepIndex = state.finalStepIndex;
+    return true;
+}
+
+void Scheduler::resetHistory() {
+    m_FinalStepIndex = (nullptr != m_StepPlan) ? static_cast<int32_t>(m_StepPlan->steps.size()) - 1 : 0;
+}
+
+bool Scheduler::checkStep(int32_t step_index) const {
+    if (nullptr == m_StepPlan) {
+        MY_LOGE("setTimesteps must succeed before running step");
+        return false;
+    }
+    if (0 == m_LatentElementCount) {
+        MY_LOGE("No scheduler buffers, setLatentShape failed");
+        return false;
+    }
+    if (step_index < 0 || static_cast<size_t>(step_index) >= m_StepPlan->steps.size()) {
+        MY_LOGE("step index %d is out of the %zu step plan", step_index, m_StepPlan->steps.size());
+        return false;
+    }
+    return true;
+}
+
 DPMSolverMultistepScheduler::~DPMSolverMultistepScheduler() {
     for (auto& model_output_data : m_ModelOutputs) {
         if (nullptr != model_output_data) {
@@ -78,18 +425,7 @@ DPMSolverMultistepScheduler::DPMSolverMultistepScheduler(int32_t num_train_times
                                                          bool thresholding, double dynamic_thresholding_ratio,
                                                          double sample_max_value, std::string algorithm_type,
                                                          std::string solver_type, bool lower_order_final) {
-    if (!trained_betas.empty()) {
-        m_Betas = trained_betas;
-    } else if (beta_schedule == "linear") {
-        m_Betas = linspace(beta_start, beta_end, num_train_timesteps);
-    } else if (beta_schedule == "scaled_linear") {
-        m_Betas = linspace(std::sqrt(beta_start), std::sqrt(beta_end), num_train_timesteps);
-        for (int32_t i = 0; i < m_Betas.size(); ++i) {
-            m_Betas[i] = m_Betas[i] * m_Betas[i];
-        }
-    } else if (beta_schedule == "squaredcos_cap_v2") {
-        m_Betas = betasForAlphaBar(num_train_timesteps);
-    }
+    m_Betas = makeBetas(num_train_timesteps, beta_start, beta_end, beta_schedule, trained_betas);
 
     double alphaCumprod = 1.0;
     for (int32_t i = 0; i < m_Betas.size(); ++i) {
@@ -110,287 +446,387 @@ DPMSolverMultistepScheduler::DPMSolverMultistepScheduler(int32_t num_train_times
         }
     }
 
-    m_InitNoiseSigma = 1.0;
-
-    auto timesteps = linspace(0, num_train_timesteps - 1, num_train_timesteps);
-    m_Timesteps.resize(timesteps.size());
-    for (int32_t i = 0; i < timesteps.size(); ++i) {
-        m_Timesteps[i] = static_cast<int32_t>(timesteps[i]);
-    }
-    std::reverse(m_Timesteps.begin(), m_Timesteps.end());
-
     m_ModelOutputs = std::vector<void*>(solver_order, nullptr);
-    for (int32_t i = 0; i < solver_order; i++) {
-        m_ModelOutputs[i] = (void*) std::malloc(TOTAL_LENGTH * sizeof(float32_t));
-    }
 
     m_LowerOrderNums = 0;
-    m_AlgorithmType = algorithm_type;
-    m_PredictionType = prediction_type;
     m_SolverOrder = solver_order;
     m_Thresholding = thresholding;
-    m_SolverType = solver_type;
     m_LowerOrderFinal = lower_order_final;
     m_NumTrainTimesteps = num_train_timesteps;
+
+    // Resolve the string options once so that step() doesn't compare strings per call
+    if (algorithm_type == "dpmsolver++") {
+        m_AlgorithmType = AlgorithmType::DPMSOLVER_PLUS_PLUS;
+    } else if (algorithm_type == "dpmsolver") {
+        m_AlgorithmType = AlgorithmType::DPMSOLVER;
+    } else {
+        MY_LOGE("algorithm_type given as %s must be one of `dpmsolver++`, or `dpmsolver`.",
+                algorithm_type.c_str());
+        m_AlgorithmType = AlgorithmType::INVALID;
+    }
+
+    if (prediction_type == "epsilon") {
+        m_PredictionType = PredictionType::EPSILON;
+    } else if (prediction_type == "sample") {
+        m_PredictionType = PredictionType::SAMPLE;
+    } else if (prediction_type == "v_prediction") {
+        m_PredictionType = PredictionType::V_PREDICTION;
+    } else {
+        MY_LOGE("prediction_type given as %s must be one of `epsilon`, `sample`, or `v_prediction` for the DPMSolverMultistepScheduler.",
+                prediction_type.c_str());
+        m_PredictionType = PredictionType::INVALID;
+    }
+
+    if (solver_type == "midpoint") {
+        m_SolverType = SolverType::MIDPOINT;
+    } else if (solver_type == "heun") {
+        m_SolverType = SolverType::HEUN;
+    } else {
+        MY_LOGE("solver_type given as %s must be one of `midpoint`, or `heun`.", solver_type.c_str());
+        m_SolverType = SolverType::INVALID;
+    }
+
+    setLatentShape(DEFAULT_LATENT_HEIGHT, DEFAULT_LATENT_WIDTH, DEFAULT_LATENT_CHANNEL);
 }
 
-void DPMSolverMultistepScheduler::setTimesteps(int32_t num_inference_steps) {
-    m_NumInferenceSteps = num_inference_steps;
-    m_InitNoiseSigma = 1.0;
+bool DPMSolverMultistepScheduler::resizeBuffers(int64_t latent_element_count, int32_t batch_size) {
+    if (latent_element_count == m_LatentElementCount && batch_size == m_BatchSize) {
+        return true;
+    }
 
-    auto timesteps = linspace(0, m_NumTrainTimesteps - 1, m_NumInferenceSteps + 1);
-    m_Timesteps.resize(timesteps.size());
-    for (int32_t i = 0; i < timesteps.size(); ++i) {
-        m_Timesteps[i] = static_cast<int32_t>(std::round(timesteps[i]));
+    const int64_t history_element_count = latent_element_count * batch_size;
+    for (auto& model_output_data : m_ModelOutputs) {
+        std::free(model_output_data);
+        model_output_data = (void*) std::malloc(history_element_count * sizeof(float32_t));
+        if (nullptr == model_output_data) {
+            MY_LOGE("Failed to allocate the model output history of %lld elements",
+                    static_cast<long long>(history_element_count));
+            return false;
+        }
     }
-    std::reverse(m_Timesteps.begin(), m_Timesteps.end());
-    m_Timesteps.pop_back();
+    return true;
+}
 
-    m_LowerOrderNums = 0;
+std::shared_ptr<const StepPlan> DPMSolverMultistepScheduler::buildStepPlan(int32_t num_inference_steps) const {
+    if (num_inference_steps <= 0) {
+        MY_LOGE("num_inference_steps given as %d must be positive", num_inference_steps);
+        return nullptr;
+    }
+
+    // The spacings covering the whole train range end on timestep 0, which is the final
+    // target of the last step rather than a step of its own
+    const bool full_range = (m_TimestepSpacing == TimestepSpacing::LINSPACE ||
+                             m_TimestepSpacing == TimestepSpacing::KARRAS ||
+                             m_TimestepSpacing == TimestepSpacing::EXPONENTIAL);
+    auto timesteps = spacedTimesteps(num_inference_steps + (full_range ? 1 : 0));
+    if (timesteps.empty()) {
+        return nullptr;
+    }
+    if (full_range) {
+        timesteps.pop_back();
+    }
+
+    auto plan = std::make_shared<StepPlan>();
+    plan->steps.resize(num_inference_steps);
+
+    const bool lower_order_tail = m_LowerOrderFinal && (num_inference_steps < 15);
+    for (int32_t i = 0; i < num_inference_steps; ++i) {
+        auto& plan_step = plan->steps[i];
+        plan_step.timestep = timesteps[i];
+        plan_step.prevTimestep = (i == num_inference_steps - 1) ? 0 : timesteps[i + 1];
+
+        if (true != convertModelOutputCoefficients(plan_step.timestep, plan_step.coeffs, plan_step.identityConversion)) {
+            MY_LOGE("Error in building the step plan");
+            return nullptr;
+        }
+
+        // Step i has min(i, solver_order) model outputs in the history when the steps run in order
+        bool lower_order_final  = (i == num_inference_steps - 1) && lower_order_tail;
+        bool lower_order_second = (i == num_inference_steps - 2) && lower_order_tail;
+
+        if (m_SolverOrder == 1 || i < 1 || lower_order_final) {
+            plan_step.order = 1;
+            dpmSolverFirstOrderCoefficients(timesteps[i], plan_step.prevTimestep, plan_step.coeffs);
+        } else if (m_SolverOrder == 2 || i < 2 || lower_order_second) {
+            plan_step.order = 2;
+            dpmSolverSecondOrderCoefficients(timesteps[i], timesteps[i - 1],
+                                             plan_step.prevTimestep, plan_step.coeffs);
+        } else {
+            plan_step.order = 3;
+            dpmSolverThirdOrderCoefficients(timesteps[i], timesteps[i - 1], timesteps[i - 2],
+                                            plan_step.prevTimestep, plan_step.coeffs);
+        }
+
+        plan_step.exitCoeffs = plan_step.coeffs;
+        dpmSolverFirstOrderCoefficients(timesteps[i], 0, plan_step.exitCoeffs);
+    }
+
+    return plan;
 }
 
-bool DPMSolverMultistepScheduler::convertModelOutput(void* model_data, int32_t timestep, void* sample_data) {
+bool DPMSolverMultistepScheduler::convertModelOutputCoefficients(int32_t timestep, StepCoefficients& coeffs,
+                                                                 bool& identity) const {
     auto alpha_t = m_Alpha_t[timestep];
     auto sigma_t = m_Sigma_t[timestep];
-    
-    auto sample = (float32_t*)sample_data;
-    auto model_output = (float32_t*)model_data;
-    if (m_AlgorithmType == "dpmsolver++") {
-        if (m_PredictionType == "epsilon") {
-            for (int64_t i = 0; i < TOTAL_LENGTH; i++, sample++, model_output++) {
-                *model_output = (*sample - (sigma_t * (*model_output))) * (1 / alpha_t);
-            }
-        } else if (m_PredictionType == "sample") {
+
+    // Every conversion has the form model_output = (p * sample + q * model_output) * r
+    coeffs.p = 0;
+    coeffs.q = 1;
+    coeffs.r = 1;
+    identity = false;
+    if (m_AlgorithmType == AlgorithmType::DPMSOLVER_PLUS_PLUS) {
+        if (m_PredictionType == PredictionType::EPSILON) {
+            coeffs.p = 1;
+            coeffs.q = -sigma_t;
+            coeffs.r = 1 / alpha_t;
+        } else if (m_PredictionType == PredictionType::SAMPLE) {
             // Do nothing since output is same as model_data
-        } else if (m_PredictionType == "v_prediction") {
-            for (int64_t i = 0; i < TOTAL_LENGTH; i++, sample++, model_output++) {
-                *model_output = alpha_t * (*sample) - sigma_t * (*model_output);
-            }
+            identity = true;
+        } else if (m_PredictionType == PredictionType::V_PREDICTION) {
+            coeffs.p = alpha_t;
+            coeffs.q = -sigma_t;
         } else {
-            MY_LOGE("prediction_type given as %s must be one of `epsilon`, `sample`, or `v_prediction` for the DPMSolverMultistepScheduler.",
-                    m_PredictionType.c_str()); 
+            MY_LOGE("prediction_type must be one of `epsilon`, `sample`, or `v_prediction` for the DPMSolverMultistepScheduler.");
             return false;
         }
-    } else if (m_AlgorithmType == "dpmsolver") {
-        if (m_PredictionType == "epsilon") {
+    } else if (m_AlgorithmType == AlgorithmType::DPMSOLVER) {
+        if (m_PredictionType == PredictionType::EPSILON) {
             // Do nothing since output is same as model_data
-        } else if (m_PredictionType == "sample") {
-            for (int64_t i = 0; i < TOTAL_LENGTH; i++, sample++, model_output++) {
-                *model_output = (*sample - (alpha_t * (*model_output))) * (1 / sigma_t);
-            }
-        } else if (m_PredictionType == "v_prediction") {
-            for (int64_t i = 0; i < TOTAL_LENGTH; i++, sample++, model_output++) {
-                *model_output = alpha_t * (*model_output) + sigma_t * (*sample);
-            }
+            identity = true;
+        } else if (m_PredictionType == PredictionType::SAMPLE) {
+            coeffs.p = 1;
+            coeffs.q = -alpha_t;
+            coeffs.r = 1 / sigma_t;
+        } else if (m_PredictionType == PredictionType::V_PREDICTION) {
+            coeffs.p = sigma_t;
+            coeffs.q = alpha_t;
         } else {
-            MY_LOGE("prediction_type given as %s must be one of `epsilon`, `sample`, or `v_prediction` for the DPMSolverMultistepScheduler.",
-                    m_PredictionType.c_str()); 
+            MY_LOGE("prediction_type must be one of `epsilon`, `sample`, or `v_prediction` for the DPMSolverMultistepScheduler.");
             return false;
         }
     } else {
-        MY_LOGE("algorithm_type given as %s must be one of `dpmsolver++`, or `dpmsolver`.",
-                m_AlgorithmType.c_str()); 
+        MY_LOGE("algorithm_type must be one of `dpmsolver++`, or `dpmsolver`.");
         return false;
     }
 
     return true;
 }
 
-void DPMSolverMultistepScheduler::dpmSolverFirstOrderUpdate(const std::vector<int32_t>& timestep_list,
-                                                            int32_t prev_timestep, void* sample_data, void* curr_output) {
-    auto t  = prev_timestep;
-    auto s0 = timestep_list[0];
-
-    auto lambda_t = m_Lambda_t[t];
-    auto lambda_s = m_Lambda_t[s0];
-    auto alpha_t  = m_Alpha_t[t];
-    auto alpha_s  = m_Alpha_t[s0];
-    auto sigma_t  = m_Sigma_t[t];
-    auto sigma_s  = m_Sigma_t[s0];
-    auto h        = lambda_t - lambda_s;
-
-    auto m0 = m_ModelOutputs[m_SolverOrder - 1];
-
-    auto D0 = (float32_t*)m0;
-
-    float32_t w0, w1;
-    if (m_AlgorithmType == "dpmsolver++") {
-        w0 = (sigma_t / sigma_s);
-        w1 = (alpha_t * (torch_exp(-h) - 1));
-    } else if (m_AlgorithmType == "dpmsolver") {
-        w0 = (alpha_t / alpha_s);
-        w1 = (sigma_t * (torch_exp(h) - 1));
-    }
-
-    auto sample = (float32_t*)sample_data;
-    auto x_t    = (float32_t*)curr_output;
-    for (int64_t i = 0; i < TOTAL_LENGTH; i++, sample++, D0++, x_t++) {
-        *x_t = w0 * (*sample) - w1 * (*D0);
-    }
-}
-
-void DPMSolverMultistepScheduler::dpmSolverSecondOrderUpdate(const std::vector<int32_t>& timestep_list,
-                                                             int32_t prev_timestep, void* sample_data, void* curr_output) {
-    auto t  = prev_timestep;
-    auto s0 = timestep_list[1];
-    auto s1 = timestep_list[0];
-
-    auto lambda_t  = m_Lambda_t[t];
-    auto lambda_s0 = m_Lambda_t[s0];
-    auto lambda_s1 = m_Lambda_t[s1];
-    auto alpha_t   = m_Alpha_t[t];
-    auto alpha_s0  = m_Alpha_t[s0];
-    auto sigma_t   = m_Sigma_t[t];
-    auto sigma_s0  = m_Sigma_t[s0];
-    auto h         = lambda_t  - lambda_s0;
-    auto h_0       = lambda_s0 - lambda_s1;
-    auto r0        = h_0 / h;
-
-    auto m0 = m_ModelOutputs[m_SolverOrder - 1];
-    auto m1 = m_ModelOutputs[m_SolverOrder - 2];
-
-    auto D0 = (float32_t*)m0;
-    std::vector<float32_t> D1(TOTAL_LENGTH);
-    auto m0_data = (float32_t*)m0;
-    auto m1_data = (float32_t*)m1;
-    for (int64_t i = 0; i < TOTAL_LENGTH; i++, m0_data++, m1_data++) {
-        D1[i] = (1 / r0) * (*m0_data - *m1_data);
-    }
-
-    float32_t w0, w1, w2;
-    if (m_AlgorithmType == "dpmsolver++") {
-        if (m_SolverType == "midpoint") {
-            w0 =       (sigma_t / sigma_s0);
-            w1 =       (alpha_t * (torch_exp(-h) - 1));
-            w2 = 0.5 * (alpha_t * (torch_exp(-h) - 1));
-        } else if (m_SolverType == "heun") {
-            w0 =  (sigma_t / sigma_s0);
-            w1 =  (alpha_t * (torch_exp(-h) - 1));
-            w2 = -(alpha_t * ((torch_exp(-h) - 1) / h + 1));
+// The weights are only computed once per plan, so they are evaluated in double precision.
+// expm1 keeps e^h - 1 accurate for the small h of long schedules.
+
+void DPMSolverMultistepScheduler::dpmSolverFirstOrderCoefficients(int32_t s0, int32_t prev_timestep,
+                                                                  StepCoefficients& coeffs) const {
+    auto t = prev_timestep;
+
+    double lambda_t = m_Lambda_t[t];
+    double lambda_s = m_Lambda_t[s0];
+    double alpha_t  = m_Alpha_t[t];
+    double alpha_s  = m_Alpha_t[s0];
+    double sigma_t  = m_Sigma_t[t];
+    double sigma_s  = m_Sigma_t[s0];
+    double h        = lambda_t - lambda_s;
+
+    if (m_AlgorithmType == AlgorithmType::DPMSOLVER_PLUS_PLUS) {
+        coeffs.w0 = static_cast<float32_t>(sigma_t / sigma_s);
+        coeffs.w1 = static_cast<float32_t>(alpha_t * std::expm1(-h));
+    } else {
+        coeffs.w0 = static_cast<float32_t>(alpha_t / alpha_s);
+        coeffs.w1 = static_cast<float32_t>(sigma_t * std::expm1(h));
+    }
+}
+
+void DPMSolverMultistepScheduler::dpmSolverSecondOrderCoefficients(int32_t s0, int32_t s1, int32_t prev_timestep,
+                                                                   StepCoefficients& coeffs) const {
+    auto t = prev_timestep;
+
+    double lambda_t  = m_Lambda_t[t];
+    double lambda_s0 = m_Lambda_t[s0];
+    double lambda_s1 = m_Lambda_t[s1];
+    double alpha_t   = m_Alpha_t[t];
+    double alpha_s0  = m_Alpha_t[s0];
+    double sigma_t   = m_Sigma_t[t];
+    double sigma_s0  = m_Sigma_t[s0];
+    double h         = lambda_t  - lambda_s0;
+    double h_0       = lambda_s0 - lambda_s1;
+    double r0        = h_0 / h;
+
+    double w0, w1, w2;
+    if (m_AlgorithmType == AlgorithmType::DPMSOLVER_PLUS_PLUS) {
+        w0 = sigma_t / sigma_s0;
+        w1 = alpha_t * std::expm1(-h);
+        if (m_SolverType == SolverType::MIDPOINT) {
+            w2 = 0.5 * w1;
+        } else {
+            w2 = -(alpha_t * (std::expm1(-h) / h + 1));
         }
-    } else if (m_AlgorithmType == "dpmsolver") {
-        if (m_SolverType == "midpoint") {
-            w0 =       (alpha_t / alpha_s0);
-            w1 =       (sigma_t * (torch_exp(h) - 1));
-            w2 = 0.5 * (sigma_t * (torch_exp(h) - 1));
-        } else if (m_SolverType == "heun") {
-            w0 = (alpha_t / alpha_s0);
-            w1 = (sigma_t * (torch_exp(h) - 1));
-            w2 = (sigma_t * ((torch_exp(h) - 1) / h - 1));
+    } else {
+        w0 = alpha_t / alpha_s0;
+        w1 = sigma_t * std::expm1(h);
+        if (m_SolverType == SolverType::MIDPOINT) {
+            w2 = 0.5 * w1;
+        } else {
+            w2 = sigma_t * (std::expm1(h) / h - 1);
         }
     }
 
-    auto sample = (float32_t*)sample_data;
-    auto x_t    = (float32_t*)curr_output;
-    for (int64_t i = 0; i < TOTAL_LENGTH; i++, sample++, D0++, x_t++) {
-        *x_t = w0 * (*sample) - w1 * (*D0) - w2 * D1[i];
-    }
+    coeffs.w0     = static_cast<float32_t>(w0);
+    coeffs.w1     = static_cast<float32_t>(w1);
+    coeffs.w2     = static_cast<float32_t>(w2);
+    coeffs.inv_r0 = static_cast<float32_t>(1 / r0);
 }
 
-void DPMSolverMultistepScheduler::dpmSolverThirdOrderUpdate(const std::vector<int32_t>& timestep_list,
-                                                            int32_t prev_timestep, void* sample_data, void* curr_output) {
-    auto t  = prev_timestep;
-    auto s0 = timestep_list[2];
-    auto s1 = timestep_list[1];
-    auto s2 = timestep_list[0];
-
-    auto lambda_t  = m_Lambda_t[t];
-    auto lambda_s0 = m_Lambda_t[s0];
-    auto lambda_s1 = m_Lambda_t[s1];
-    auto lambda_s2 = m_Lambda_t[s2];
-    auto alpha_t   = m_Alpha_t[t];
-    auto alpha_s0  = m_Alpha_t[s0];
-    auto sigma_t   = m_Sigma_t[t];
-    auto sigma_s0  = m_Sigma_t[s0];
-    auto h         = lambda_t - lambda_s0;
-    auto h_0       = lambda_s0 - lambda_s1;
-    auto h_1       = lambda_s1 - lambda_s2;
-    auto r0        = h_0 / h;
-    auto r1        = h_1 / h;
+void DPMSolverMultistepScheduler::dpmSolverThirdOrderCoefficients(int32_t s0, int32_t s1, int32_t s2,
+                                                                  int32_t prev_timestep, StepCoefficients& coeffs) const {
+    auto t = prev_timestep;
+
+    double lambda_t  = m_Lambda_t[t];
+    double lambda_s0 = m_Lambda_t[s0];
+    double lambda_s1 = m_Lambda_t[s1];
+    double lambda_s2 = m_Lambda_t[s2];
+    double alpha_t   = m_Alpha_t[t];
+    double alpha_s0  = m_Alpha_t[s0];
+    double sigma_t   = m_Sigma_t[t];
+    double sigma_s0  = m_Sigma_t[s0];
+    double h         = lambda_t - lambda_s0;
+    double h_0       = lambda_s0 - lambda_s1;
+    double h_1       = lambda_s1 - lambda_s2;
+    double r0        = h_0 / h;
+    double r1        = h_1 / h;
+
+    double w0, w1, w2, w3;
+    if (m_AlgorithmType == AlgorithmType::DPMSOLVER_PLUS_PLUS) {
+        w0 =  sigma_t / sigma_s0;
+        w1 =  alpha_t * std::expm1(-h);
+        w2 = -(alpha_t * (std::expm1(-h) / h + 1));
+        w3 =  alpha_t * ((std::expm1(-h) + h) / (h * h) - 0.5);
+    } else {
+        w0 = alpha_t / alpha_s0;
+        w1 = sigma_t * std::expm1(h);
+        w2 = sigma_t * (std::expm1(h) / h - 1);
+        w3 = sigma_t * ((std::expm1(h) - h) / (h * h) - 0.5);
+    }
 
-    auto m0 = m_ModelOutputs[m_SolverOrder - 1];
-    auto m1 = m_ModelOutputs[m_SolverOrder - 2];
-    auto m2 = m_ModelOutputs[m_SolverOrder - 3];
+    coeffs.w0          = static_cast<float32_t>(w0);
+    coeffs.w1          = static_cast<float32_t>(w1);
+    coeffs.w2          = static_cast<float32_t>(w2);
+    coeffs.w3          = static_cast<float32_t>(w3);
+    coeffs.inv_r0      = static_cast<float32_t>(1 / r0);
+    coeffs.inv_r1      = static_cast<float32_t>(1 / r1);
+    coeffs.r0_over_r01 = static_cast<float32_t>(r0 / (r0 + r1));
+    coeffs.inv_r01     = static_cast<float32_t>(1 / (r0 + r1));
+}
 
-    auto D0 = (float32_t*)m0;
-    std::vector<float32_t> D1(TOTAL_LENGTH);
-    std::vector<float32_t> D2(TOTAL_LENGTH);
-    auto m0_data = (float32_t*)m0;
-    auto m1_data = (float32_t*)m1;
-    auto m2_data = (float32_t*)m2;
-    for (int64_t i = 0; i < TOTAL_LENGTH; i++, m0_data++, m1_data++, m2_data++) {
-        auto D1_0 = (1 / r0) * (*m0_data - *m1_data);
-        auto D1_1 = (1 / r1) * (*m1_data - *m2_data);
+void DPMSolverMultistepScheduler::resetHistory() {
+    Scheduler::resetHistory();
+    m_LowerOrderNums = 0;
+}
 
-        D1[i] = D1_0 + (r0 / (r0 + r1)) * (D1_0 - D1_1);
-        D2[i] = (1 / (r0 + r1)) * (D1_0 - D1_1);
+void DPMSolverMultistepScheduler::saveHistory(SchedulerState& state) const {
+    // Slots are stored oldest first, which is the rotation order of stepBatch
+    const int64_t slot_element_count = m_LatentElementCount * m_BatchSize;
+    state.history.resize(slot_element_count * m_ModelOutputs.size());
+    for (size_t i = 0; i < m_ModelOutputs.size(); ++i) {
+        std::memcpy(state.history.data() + i * slot_element_count, m_ModelOutputs[i],
+                    slot_element_count * sizeof(float32_t));
     }
+    state.historyCount = m_LowerOrderNums;
+}
 
-    float32_t w0, w1, w2, w3;
-    if (m_AlgorithmType == "dpmsolver++") {
-        w0 =  (sigma_t / sigma_s0);
-        w1 =  (alpha_t * (torch_exp(-h) - 1));
-        w2 = -(alpha_t * ((torch_exp(-h) - 1) / h + 1));
-        w3 =  (alpha_t * ((torch_exp(-h) - 1 + h) / std::pow(h, 2) - 0.5));
-    } else if (m_AlgorithmType == "dpmsolver") {
-        w0 = (alpha_t / alpha_s0);
-        w1 = (sigma_t * (torch_exp(h) - 1));
-        w2 = (sigma_t * ((torch_exp(h) - 1) / h - 1));
-        w3 = (sigma_t * ((torch_exp(h) - 1 - h) / std::pow(h, 2) - 0.5));
+bool DPMSolverMultistepScheduler::loadHistory(const SchedulerState& state) {
+    const int64_t slot_element_count = m_LatentElementCount * m_BatchSize;
+    if (state.history.size() != slot_element_count * m_ModelOutputs.size()) {
+        MY_LOGE("The scheduler state holds no DPM-Solver history of order %d", m_SolverOrder);
+        return false;
     }
-
-    auto sample = (float32_t*)sample_data;
-    auto x_t    = (float32_t*)curr_output;
-    for (int64_t i = 0; i < TOTAL_LENGTH; i++, sample++, D0++, x_t++) {
-        *x_t = w0 * (*sample) - w1 * (*D0) - w2 * D1[i] - w3 * D2[i];
+    for (size_t i = 0; i < m_ModelOutputs.size(); ++i) {
+        std::memcpy(m_ModelOutputs[i], state.history.data() + i * slot_element_count,
+                    slot_element_count * sizeof(float32_t));
     }
+    m_LowerOrderNums = state.historyCount;
+    return true;
 }
 
-bool DPMSolverMultistepScheduler::step(void* model_output, int32_t timestep, void* prev_output, void* curr_output) {
-
-    auto uncond_ptr = (float32_t*) model_output;
-    auto cond_ptr   = uncond_ptr + TOTAL_LENGTH;
-    auto model_data = (float32_t*) m_ModelOutputs[0];
-    for (int32_t i = 0; i < TOTAL_LENGTH; i++, cond_ptr++, uncond_ptr++) {
-        model_data[i] = *uncond_ptr + m_GuidanceScale * (*cond_ptr - *uncond_ptr);
-    }
+bool DPMSolverMultistepScheduler::runStep(const ModelOutputs& model_output, int32_t step_index, bool final_jump,
+                                          void* prev_output, void* curr_output,
+                                          const QuantizedLatents& quantized_latents) {
+    const auto& plan_step = m_StepPlan->steps[step_index];
+    const auto order = final_jump ? 1 : plan_step.order;
 
-    if (true != convertModelOutput((void*) model_data, timestep, prev_output)) {
-        MY_LOGE("Error in running convertModelOutput");
+    // The plan assumes the history was filled by the preceding steps
+    if (order > m_LowerOrderNums + 1) {
+        MY_LOGE("step %d needs %d previous model outputs but only %d are available",
+                step_index, order - 1, m_LowerOrderNums);
         return false;
     }
 
+    StepCoefficients coeffs = final_jump ? plan_step.exitCoeffs : plan_step.coeffs;
+    coeffs.guidance = m_GuidanceScale;
+    coeffs.dequant_scale = model_output.scale;
+    coeffs.dequant_bias = model_output.bias;
+    coeffs.quant_multiplier = quantized_latents.multiplier;
+    coeffs.quant_bias = quantized_latents.bias;
+
+    // Rotate the history first, the oldest buffer receives the new converted model output
+    auto model_data = m_ModelOutputs[0];
     for (int32_t i = 0; i < m_SolverOrder - 1; ++i) {
         m_ModelOutputs[i] = m_ModelOutputs[i + 1];
     }
-    m_ModelOutputs[m_SolverOrder - 1] = (void*) model_data;
-
-    auto it = std::find(m_Timesteps.begin(), m_Timesteps.end(), timestep);
-    auto step_index = m_NumInferenceSteps - 1;
-    if (it != m_Timesteps.end()) {
-        step_index = it - m_Timesteps.begin();
-    }
-
-    int32_t prev_timestep = 0;
-    if (step_index != (m_NumInferenceSteps - 1)) {
-        prev_timestep = m_Timesteps[step_index + 1];
-    }
+    m_ModelOutputs[m_SolverOrder - 1] = model_data;
+
+    // Every latent of the batch shares the coefficients, the kernels run once per latent so
+    // the fixed-size tables still apply
+    const auto n = m_LatentElementCount;
+    for (int32_t b = 0; b < m_BatchSize; ++b) {
+        // The float outputs are null when the step reads the quantized ones
+        auto uncond_ptr = model_output.quantized() ? nullptr : model_output.uncond + b * n;
+        auto cond_ptr   = model_output.quantized() ? nullptr : model_output.cond + b * n;
+        auto sample     = (const float32_t*) prev_output + b * n;
+        auto x          = (float32_t*) curr_output + b * n;
+        auto m0         = (float32_t*) m_ModelOutputs[m_SolverOrder - 1] + b * n;
+        auto m1         = (order > 1) ? (const float32_t*) m_ModelOutputs[m_SolverOrder - 2] + b * n : nullptr;
+        auto m2         = (order > 2) ? (const float32_t*) m_ModelOutputs[m_SolverOrder - 3] + b * n : nullptr;
+        auto xq         = quantized_latents.data ? quantized_latents.data + b * n : nullptr;
+
+        if (model_output.quantized()) {
+            auto uncond_q = model_output.uncondQuantized + b * n;
+            auto cond_q   = model_output.condQuantized + b * n;
+            if (order == 1) {
+                m_Kernels->fusedFirstOrderQuantized(x, xq, m0, sample, uncond_q, cond_q, coeffs, n);
+            } else if (order == 2) {
+                m_Kernels->fusedSecondOrderQuantized(x, xq, m0, sample, uncond_q, cond_q, m1, coeffs, n);
+            } else {
+                m_Kernels->fusedThirdOrderQuantized(x, xq, m0, sample, uncond_q, cond_q, m1, m2, coeffs, n);
+            }
+            // Written by the fused kernel
+            xq = nullptr;
+        } else if (m_FusedStep) {
+            if (order == 1) {
+                m_Kernels->fusedFirstOrder(x, m0, sample, uncond_ptr, cond_ptr, coeffs, n);
+            } else if (order == 2) {
+                m_Kernels->fusedSecondOrder(x, m0, sample, uncond_ptr, cond_ptr, m1, coeffs, n);
+            } else {
+                m_Kernels->fusedThirdOrder(x, m0, sample, uncond_ptr, cond_ptr, m1, m2, coeffs, n);
+            }
+        } else {
+            m_Kernels->guidance(m0, uncond_ptr, cond_ptr, coeffs.guidance, n);
+            if (!plan_step.identityConversion) {
+                m_Kernels->convert(m0, sample, coeffs.p, coeffs.q, coeffs.r, n);
+            }
 
-    bool lower_order_final  = ((step_index == (m_NumInferenceSteps - 1)) && m_LowerOrderFinal && (m_NumInferenceSteps < 15));
-    bool lower_order_second = ((step_index == (m_NumInferenceSteps - 2)) && m_LowerOrderFinal && (m_NumInferenceSteps < 15));
+            if (order == 1) {
+                m_Kernels->firstOrder(x, sample, m0, coeffs.w0, coeffs.w1, n);
+            } else if (order == 2) {
+                m_Kernels->secondOrder(x, sample, m0, m1, coeffs.w0, coeffs.w1, coeffs.w2, coeffs.inv_r0, n);
+            } else {
+                m_Kernels->thirdOrder(x, sample, m0, m1, m2, coeffs.w0, coeffs.w1, coeffs.w2, coeffs.w3,
+                                      coeffs.inv_r0, coeffs.inv_r1, coeffs.r0_over_r01, coeffs.inv_r01, n);
+            }
+        }
 
-    if (m_SolverOrder == 1 || m_LowerOrderNums < 1 || lower_order_final) {
-        dpmSolverFirstOrderUpdate({timestep},
-                                  prev_timestep, prev_output, curr_output);
-    } else if (m_SolverOrder == 2 || m_LowerOrderNums < 2 || lower_order_second) {
-        dpmSolverSecondOrderUpdate({m_Timesteps[(m_NumInferenceSteps + step_index - 1) % m_NumInferenceSteps],
-                                    timestep},
-                                   prev_timestep, prev_output, curr_output);
-    } else {
-        dpmSolverThirdOrderUpdate({m_Timesteps[(m_NumInferenceSteps + step_index - 2) % m_NumInferenceSteps],
-                                   m_Timesteps[(m_NumInferenceSteps + step_index - 1) % m_NumInferenceSteps],
-                                   timestep},
-                                  prev_timestep, prev_output, curr_output);
+        if (nullptr != xq) {
+            m_Kernels->quantize(xq, x, quantized_latents.multiplier, quantized_latents.bias, n);
+        }
     }
 
     if (m_LowerOrderNums < m_SolverOrder) {
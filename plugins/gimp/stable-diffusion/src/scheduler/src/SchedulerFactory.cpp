@@ -0,0 +1,53 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#include "SchedulerFactory.hpp"
+#include "SingleStepScheduler.hpp"
+
+#ifdef BUILD_RELEASE
+#define MY_LOGE(format, ...)
+#else
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOGTAG "Scheduler"
+#define MY_LOGE(format, ...) __android_log_print(ANDROID_LOG_ERROR, LOGTAG, format, ##__VA_ARGS__)
+#else
+#define MY_LOGE(format, ...) printf("Scheduler ERROR: "#format "\n", ##__VA_ARGS__)
+#endif
+#endif
+
+Scheduler* createScheduler(const std::string& scheduler_type, int32_t num_train_timesteps,
+                           double beta_start, double beta_end, const std::string& beta_schedule,
+                           const std::vector<float32_t>& trained_betas,
+                           const std::vector<float32_t>& trained_lambdas)
+{
+    if (scheduler_type == "dpmsolver++")
+    {
+        return new DPMSolverMultistepScheduler(num_train_timesteps, beta_start, beta_end, beta_schedule,
+                                               trained_betas, trained_lambdas);
+    }
+    else if (scheduler_type == "euler")
+    {
+        return new EulerDiscreteScheduler(num_train_timesteps, beta_start, beta_end, beta_schedule,
+                                          trained_betas, "epsilon", /*ancestral=*/false);
+    }
+    else if (scheduler_type == "euler_ancestral")
+    {
+        return new EulerDiscreteScheduler(num_train_timesteps, beta_start, beta_end, beta_schedule,
+                                          trained_betas, "epsilon", /*ancestral=*/true);
+    }
+    else if (scheduler_type == "ddim")
+    {
+        return new DDIMScheduler(num_train_timesteps, beta_start, beta_end, beta_schedule, trained_betas);
+    }
+    else if (scheduler_type == "lcm")
+    {
+        return new LCMScheduler(num_train_timesteps, beta_start, beta_end, beta_schedule, trained_betas);
+    }
+
+    MY_LOGE("scheduler_type given as %s must be one of `dpmsolver++`, `euler`, `euler_ancestral`, `ddim`, or `lcm`.",
+            scheduler_type.c_str());
+    return nullptr;
+}
@@ -0,0 +1,325 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#include "SchedulerKernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#if defined(CPU_FEATURES_X86_64)
+#include <immintrin.h>
+#elif defined(CPU_FEATURES_ARM64)
+#include <arm_neon.h>
+#endif
+
+// Largest value of the 16 bit encoding of the QNN tensors
+#define QUANT_MAX 65535.0f
+
+// Scalar wrapper, used as the reference implementation and for loop tails
+struct ScalarOps {
+    using V = float32_t;
+    static constexpr int64_t W = 1;
+    static inline V load(const float32_t* p) { return *p; }
+    static inline V loadU16(const uint16_t* p) { return static_cast<float32_t>(*p); }
+    static inline void store(float32_t* p, V v) { *p = v; }
+    // Clamps to [0, 65535] and truncates, like the QuantKernels quantization
+    static inline void storeU16(uint16_t* p, V v)
+    {
+        *p = static_cast<uint16_t>(v < 0.0f ? 0.0f : v > QUANT_MAX ? QUANT_MAX : v);
+    }
+    static inline V set1(float32_t v) { return v; }
+    static inline V add(V a, V b) { return a + b; }
+    static inline V sub(V a, V b) { return a - b; }
+    static inline V mul(V a, V b) { return a * b; }
+    // a * b + c
+    static inline V fmadd(V a, V b, V c) { return a * b + c; }
+    // c - a * b
+    static inline V fnmadd(V a, V b, V c) { return c - a * b; }
+};
+
+namespace scalar {
+using Ops = ScalarOps;
+#include "SchedulerKernels.inl"
+} // namespace scalar
+
+#if defined(CPU_FEATURES_X86_64)
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+namespace avx2 {
+struct Ops {
+    using V = __m256;
+    static constexpr int64_t W = 8;
+    static inline V load(const float32_t* p) { return _mm256_loadu_ps(p); }
+    static inline V loadU16(const uint16_t* p)
+    {
+        return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+    }
+    static inline void store(float32_t* p, V v) { _mm256_storeu_ps(p, v); }
+    static inline void storeU16(uint16_t* p, V v)
+    {
+        __m256i q = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(QUANT_MAX)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                         _mm_packus_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1)));
+    }
+    static inline V set1(float32_t v) { return _mm256_set1_ps(v); }
+    static inline V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static inline V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static inline V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static inline V fmadd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    static inline V fnmadd(V a, V b, V c) { return _mm256_fnmadd_ps(a, b, c); }
+};
+#include "SchedulerKernels.inl"
+} // namespace avx2
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+namespace avx512 {
+struct Ops {
+    using V = __m512;
+    static constexpr int64_t W = 16;
+    static inline V load(const float32_t* p) { return _mm512_loadu_ps(p); }
+    static inline V loadU16(const uint16_t* p)
+    {
+        return _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))));
+    }
+    static inline void store(float32_t* p, V v) { _mm512_storeu_ps(p, v); }
+    static inline void storeU16(uint16_t* p, V v)
+    {
+        __m512i q = _mm512_cvttps_epi32(_mm512_min_ps(_mm512_max_ps(v, _mm512_setzero_ps()), _mm512_set1_ps(QUANT_MAX)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_cvtepi32_epi16(q));
+    }
+    static inline V set1(float32_t v) { return _mm512_set1_ps(v); }
+    static inline V add(V a, V b) { return _mm512_add_ps(a, b); }
+    static inline V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+    static inline V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+    static inline V fmadd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+    static inline V fnmadd(V a, V b, V c) { return _mm512_fnmadd_ps(a, b, c); }
+};
+#include "SchedulerKernels.inl"
+} // namespace avx512
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#elif defined(CPU_FEATURES_ARM64)
+
+namespace neon {
+struct Ops {
+    using V = float32x4_t;
+    static constexpr int64_t W = 4;
+    static inline V load(const float32_t* p) { return vld1q_f32(p); }
+    static inline V loadU16(const uint16_t* p) { return vcvtq_f32_u32(vmovl_u16(vld1_u16(p))); }
+    static inline void store(float32_t* p, V v) { vst1q_f32(p, v); }
+    static inline void storeU16(uint16_t* p, V v)
+    {
+        V clamped = vminq_f32(vmaxq_f32(v, vdupq_n_f32(0.0f)), vdupq_n_f32(QUANT_MAX));
+        vst1_u16(p, vmovn_u32(vcvtq_u32_f32(clamped)));
+    }
+    static inline V set1(float32_t v) { return vdupq_n_f32(v); }
+    static inline V add(V a, V b) { return vaddq_f32(a, b); }
+    static inline V sub(V a, V b) { return vsubq_f32(a, b); }
+    static inline V mul(V a, V b) { return vmulq_f32(a, b); }
+    static inline V fmadd(V a, V b, V c) { return vfmaq_f32(c, a, b); }
+    static inline V fnmadd(V a, V b, V c) { return vfmsq_f32(c, a, b); }
+};
+#include "SchedulerKernels.inl"
+} // namespace neon
+
+#endif
+
+// Picks the fixed-size table of an ISA namespace when one matches n
+#define SELECT_KERNEL_TABLE(ns, n)                   \
+    ((n) == kLatentCount64x64 ? ns::kKernels64x64 :  \
+     (n) == kLatentCount96x96 ? ns::kKernels96x96 : ns::kKernels)
+
+const SchedulerKernels& getSchedulerKernels(CpuFeatures::Isa isa, int64_t n)
+{
+    switch (isa)
+    {
+#if defined(CPU_FEATURES_X86_64)
+    case CpuFeatures::Isa::AVX512:
+        return SELECT_KERNEL_TABLE(avx512, n);
+    case CpuFeatures::Isa::AVX2:
+        return SELECT_KERNEL_TABLE(avx2, n);
+#elif defined(CPU_FEATURES_ARM64)
+    case CpuFeatures::Isa::NEON:
+        return SELECT_KERNEL_TABLE(neon, n);
+#endif
+    default:
+        return SELECT_KERNEL_TABLE(scalar, n);
+    }
+}
+
+static bool allClose(const std::vector<float32_t>& a, const std::vector<float32_t>& b, float32_t tolerance)
+{
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (std::fabs(a[i] - b[i]) > tolerance * std::max(1.0f, std::fabs(b[i])))
+            return false;
+    }
+    return true;
+}
+
+// FMA contraction may move a value across a rounding boundary, allow one step
+static bool quantizedClose(const std::vector<uint16_t>& a, const std::vector<uint16_t>& b)
+{
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (std::abs(static_cast<int32_t>(a[i]) - static_cast<int32_t>(b[i])) > 1)
+            return false;
+    }
+    return true;
+}
+
+bool verifySchedulerKernels(CpuFeatures::Isa isa, int64_t n, float32_t tolerance)
+{
+    const auto& kernels = getSchedulerKernels(isa, n);
+    const auto& reference = getSchedulerKernels(CpuFeatures::Isa::SCALAR, n);
+    if (&kernels == &reference)
+        return true;
+
+    // Deterministic pseudo-random inputs in [-1, 1]
+    uint32_t state = 0x9e3779b9u;
+    auto next = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<float32_t>(state >> 8) / static_cast<float32_t>(1u << 23) - 1.0f;
+    };
+    std::vector<float32_t> sample(n), m0(n), m1(n), m2(n);
+    for (int64_t i = 0; i < n; i++)
+    {
+        sample[i] = next();
+        m0[i] = next();
+        m1[i] = next();
+        m2[i] = next();
+    }
+
+    std::vector<float32_t> out(n), ref(n);
+
+    kernels.guidance(out.data(), m0.data(), m1.data(), 7.5f, n);
+    reference.guidance(ref.data(), m0.data(), m1.data(), 7.5f, n);
+    if (!allClose(out, ref, tolerance))
+        return false;
+
+    out = m0;
+    ref = m0;
+    kernels.convert(out.data(), sample.data(), 1.0f, -0.7f, 1.3f, n);
+    reference.convert(ref.data(), sample.data(), 1.0f, -0.7f, 1.3f, n);
+    if (!allClose(out, ref, tolerance))
+        return false;
+
+    kernels.firstOrder(out.data(), sample.data(), m0.data(), 0.9f, -0.2f, n);
+    reference.firstOrder(ref.data(), sample.data(), m0.data(), 0.9f, -0.2f, n);
+    if (!allClose(out, ref, tolerance))
+        return false;
+
+    kernels.secondOrder(out.data(), sample.data(), m0.data(), m1.data(), 0.9f, -0.2f, -0.1f, 1.1f, n);
+    reference.secondOrder(ref.data(), sample.data(), m0.data(), m1.data(), 0.9f, -0.2f, -0.1f, 1.1f, n);
+    if (!allClose(out, ref, tolerance))
+        return false;
+
+    kernels.thirdOrder(out.data(), sample.data(), m0.data(), m1.data(), m2.data(),
+                       0.9f, -0.2f, -0.1f, 0.05f, 1.1f, 0.9f, 0.55f, 0.5f, n);
+    reference.thirdOrder(ref.data(), sample.data(), m0.data(), m1.data(), m2.data(),
+                         0.9f, -0.2f, -0.1f, 0.05f, 1.1f, 0.9f, 0.55f, 0.5f, n);
+    if (!allClose(out, ref, tolerance))
+        return false;
+
+    StepCoefficients coeffs;
+    coeffs.guidance = 7.5f;
+    coeffs.p = 1.0f;
+    coeffs.q = -0.7f;
+    coeffs.r = 1.3f;
+    coeffs.w0 = 0.9f;
+    coeffs.w1 = -0.2f;
+    coeffs.w2 = -0.1f;
+    coeffs.w3 = 0.05f;
+    coeffs.inv_r0 = 1.1f;
+    coeffs.inv_r1 = 0.9f;
+    coeffs.r0_over_r01 = 0.55f;
+    coeffs.inv_r01 = 0.5f;
+
+    // The fused kernels also write the converted model output, check both
+    std::vector<float32_t> hist(n), histRef(n);
+
+    kernels.fusedFirstOrder(out.data(), hist.data(), sample.data(), m0.data(), m1.data(), coeffs, n);
+    reference.fusedFirstOrder(ref.data(), histRef.data(), sample.data(), m0.data(), m1.data(), coeffs, n);
+    if (!allClose(out, ref, tolerance) || !allClose(hist, histRef, tolerance))
+        return false;
+
+    kernels.fusedSecondOrder(out.data(), hist.data(), sample.data(), m0.data(), m1.data(), m2.data(), coeffs, n);
+    reference.fusedSecondOrder(ref.data(), histRef.data(), sample.data(), m0.data(), m1.data(), m2.data(), coeffs, n);
+    if (!allClose(out, ref, tolerance) || !allClose(hist, histRef, tolerance))
+        return false;
+
+    kernels.fusedThirdOrder(out.data(), hist.data(), sample.data(), m0.data(), m1.data(), m2.data(), sample.data(),
+                            coeffs, n);
+    reference.fusedThirdOrder(ref.data(), histRef.data(), sample.data(), m0.data(), m1.data(), m2.data(), sample.data(),
+                              coeffs, n);
+    if (!allClose(out, ref, tolerance) || !allClose(hist, histRef, tolerance))
+        return false;
+
+    // Raw UNet outputs covering the whole uint16 range
+    std::vector<uint16_t> uncondQ(n), condQ(n);
+    for (int64_t i = 0; i < n; i++)
+    {
+        uncondQ[i] = static_cast<uint16_t>(state >> 16);
+        next();
+        condQ[i] = static_cast<uint16_t>(state >> 16);
+        next();
+    }
+    coeffs.dequant_scale = 2.0f / 65535.0f;
+    coeffs.dequant_bias = -1.0f;
+
+    // Once without and once with the quantized copy of the latent, in the encoding of a latent in [-8, 8]
+    coeffs.quant_multiplier = 65535.0f / 16.0f;
+    coeffs.quant_bias = 32768.0f;
+    std::vector<uint16_t> quantized(n), quantizedRef(n);
+    for (uint16_t* xq : { (uint16_t*)nullptr, quantized.data() })
+    {
+        uint16_t* xqRef = xq ? quantizedRef.data() : nullptr;
+
+        kernels.fusedFirstOrderQuantized(out.data(), xq, hist.data(), sample.data(), uncondQ.data(), condQ.data(),
+                                         coeffs, n);
+        reference.fusedFirstOrderQuantized(ref.data(), xqRef, histRef.data(), sample.data(), uncondQ.data(), condQ.data(),
+                                           coeffs, n);
+        if (!allClose(out, ref, tolerance) || !allClose(hist, histRef, tolerance) || !quantizedClose(quantized, quantizedRef))
+            return false;
+
+        kernels.fusedSecondOrderQuantized(out.data(), xq, hist.data(), sample.data(), uncondQ.data(), condQ.data(),
+                                          m2.data(), coeffs, n);
+        reference.fusedSecondOrderQuantized(ref.data(), xqRef, histRef.data(), sample.data(), uncondQ.data(), condQ.data(),
+                                            m2.data(), coeffs, n);
+        if (!allClose(out, ref, tolerance) || !allClose(hist, histRef, tolerance) || !quantizedClose(quantized, quantizedRef))
+            return false;
+
+        kernels.fusedThirdOrderQuantized(out.data(), xq, hist.data(), sample.data(), uncondQ.data(), condQ.data(),
+                                         m2.data(), sample.data(), coeffs, n);
+        reference.fusedThirdOrderQuantized(ref.data(), xqRef, histRef.data(), sample.data(), uncondQ.data(), condQ.data(),
+                                           m2.data(), sample.data(), coeffs, n);
+        if (!allClose(out, ref, tolerance) || !allClose(hist, histRef, tolerance) || !quantizedClose(quantized, quantizedRef))
+            return false;
+    }
+
+    kernels.quantize(quantized.data(), sample.data(), 65535.0f / 2.0f, 32768.0f, n);
+    reference.quantize(quantizedRef.data(), sample.data(), 65535.0f / 2.0f, 32768.0f, n);
+    return quantizedClose(quantized, quantizedRef);
+}
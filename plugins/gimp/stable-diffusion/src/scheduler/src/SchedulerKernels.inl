@@ -0,0 +1,390 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+// Kernel bodies shared by every ISA. This file is included once per ISA from
+// SchedulerKernels.cpp inside a namespace which defines `Ops`, the vector
+// wrapper for that ISA. Tail elements which do not fill a full vector go
+// through ScalarOps so that every element sees the same arithmetic.
+//
+// Every kernel is instantiated with a compile-time element count N. N == 0
+// is the generic version using the runtime count, the fixed sizes let the
+// compiler drop the tail loop and unroll the main one.
+
+template <int64_t N>
+static constexpr bool kNeedsTail = (N == 0) || (N % Ops::W != 0);
+
+template <class O>
+static inline void guidanceBlock(float32_t* out, const float32_t* uncond, const float32_t* cond,
+                                 typename O::V scale)
+{
+    auto u = O::load(uncond);
+    O::store(out, O::fmadd(scale, O::sub(O::load(cond), u), u));
+}
+
+template <int64_t N>
+static void guidance(float32_t* out, const float32_t* uncond, const float32_t* cond,
+                     float32_t scale, int64_t n)
+{
+    n = (N != 0) ? N : n;
+    const auto vscale = Ops::set1(scale);
+    int64_t i = 0;
+    for (; i + Ops::W <= n; i += Ops::W)
+        guidanceBlock<Ops>(out + i, uncond + i, cond + i, vscale);
+    for (; kNeedsTail<N> && i < n; i++)
+        guidanceBlock<ScalarOps>(out + i, uncond + i, cond + i, scale);
+}
+
+template <class O>
+static inline void convertBlock(float32_t* model, const float32_t* sample,
+                                typename O::V p, typename O::V q, typename O::V r)
+{
+    O::store(model, O::mul(O::fmadd(q, O::load(model), O::mul(p, O::load(sample))), r));
+}
+
+template <int64_t N>
+static void convert(float32_t* model, const float32_t* sample,
+                    float32_t p, float32_t q, float32_t r, int64_t n)
+{
+    n = (N != 0) ? N : n;
+    const auto vp = Ops::set1(p), vq = Ops::set1(q), vr = Ops::set1(r);
+    int64_t i = 0;
+    for (; i + Ops::W <= n; i += Ops::W)
+        convertBlock<Ops>(model + i, sample + i, vp, vq, vr);
+    for (; kNeedsTail<N> && i < n; i++)
+        convertBlock<ScalarOps>(model + i, sample + i, p, q, r);
+}
+
+template <class O>
+static inline void quantizeBlock(uint16_t* q, const float32_t* x, typename O::V multiplier, typename O::V bias)
+{
+    O::storeU16(q, O::fmadd(O::load(x), multiplier, bias));
+}
+
+template <int64_t N>
+static void quantize(uint16_t* q, const float32_t* x, float32_t multiplier, float32_t bias, int64_t n)
+{
+    n = (N != 0) ? N : n;
+    const auto vmultiplier = Ops::set1(multiplier), vbias = Ops::set1(bias);
+    int64_t i = 0;
+    for (; i + Ops::W <= n; i += Ops::W)
+        quantizeBlock<Ops>(q + i, x + i, vmultiplier, vbias);
+    for (; kNeedsTail<N> && i < n; i++)
+        quantizeBlock<ScalarOps>(q + i, x + i, multiplier, bias);
+}
+
+template <class O>
+static inline void firstOrderBlock(float32_t* x, const float32_t* sample, const float32_t* m0,
+                                   typename O::V w0, typename O::V w1)
+{
+    O::store(x, O::fnmadd(w1, O::load(m0), O::mul(w0, O::load(sample))));
+}
+
+template <int64_t N>
+static void firstOrder(float32_t* x, const float32_t* sample, const float32_t* m0,
+                       float32_t w0, float32_t w1, int64_t n)
+{
+    n = (N != 0) ? N : n;
+    const auto vw0 = Ops::set1(w0), vw1 = Ops::set1(w1);
+    int64_t i = 0;
+    for (; i + Ops::W <= n; i += Ops::W)
+        firstOrderBlock<Ops>(x + i, sample + i, m0 + i, vw0, vw1);
+    for (; kNeedsTail<N> && i < n; i++)
+        firstOrderBlock<ScalarOps>(x + i, sample + i, m0 + i, w0, w1);
+}
+
+template <class O>
+static inline void secondOrderBlock(float32_t* x, const float32_t* sample,
+                                    const float32_t* m0, const float32_t* m1,
+                                    typename O::V w0, typename O::V w1, typename O::V w2,
+                                    typename O::V inv_r0)
+{
+    auto d0 = O::load(m0);
+    auto d1 = O::mul(inv_r0, O::sub(d0, O::load(m1)));
+    auto acc = O::fnmadd(w1, d0, O::mul(w0, O::load(sample)));
+    O::store(x, O::fnmadd(w2, d1, acc));
+}
+
+template <int64_t N>
+static void secondOrder(float32_t* x, const float32_t* sample, const float32_t* m0, const float32_t* m1,
+                        float32_t w0, float32_t w1, float32_t w2, float32_t inv_r0, int64_t n)
+{
+    n = (N != 0) ? N : n;
+    const auto vw0 = Ops::set1(w0), vw1 = Ops::set1(w1), vw2 = Ops::set1(w2);
+    const auto vinv_r0 = Ops::set1(inv_r0);
+    int64_t i = 0;
+    for (; i + Ops::W <= n; i += Ops::W)
+        secondOrderBlock<Ops>(x + i, sample + i, m0 + i, m1 + i, vw0, vw1, vw2, vinv_r0);
+    for (; kNeedsTail<N> && i < n; i++)
+        secondOrderBlock<ScalarOps>(x + i, sample + i, m0 + i, m1 + i, w0, w1, w2, inv_r0);
+}
+
+template <class O>
+static inline void thirdOrderBlock(float32_t* x, const float32_t* sample,
+                                   const float32_t* m0, const float32_t* m1, const float32_t* m2,
+                                   typename O::V w0, typename O::V w1, typename O::V w2, typename O::V w3,
+                                   typename O::V inv_r0, typename O::V inv_r1,
+                                   typename O::V r0_over_r01, typename O::V inv_r01)
+{
+    auto d0   = O::load(m0);
+    auto v1   = O::load(m1);
+    auto d1_0 = O::mul(inv_r0, O::sub(d0, v1));
+    auto d1_1 = O::mul(inv_r1, O::sub(v1, O::load(m2)));
+    auto diff = O::sub(d1_0, d1_1);
+    auto d1   = O::fmadd(r0_over_r01, diff, d1_0);
+    auto d2   = O::mul(inv_r01, diff);
+    auto acc  = O::fnmadd(w1, d0, O::mul(w0, O::load(sample)));
+    acc       = O::fnmadd(w2, d1, acc);
+    O::store(x, O::fnmadd(w3, d2, acc));
+}
+
+template <int64_t N>
+static void thirdOrder(float32_t* x, const float32_t* sample,
+                       const float32_t* m0, const float32_t* m1, const float32_t* m2,
+                       float32_t w0, float32_t w1, float32_t w2, float32_t w3,
+                       float32_t inv_r0, float32_t inv_r1, float32_t r0_over_r01, float32_t inv_r01,
+                       int64_t n)
+{
+    n = (N != 0) ? N : n;
+    const auto vw0 = Ops::set1(w0), vw1 = Ops::set1(w1), vw2 = Ops::set1(w2), vw3 = Ops::set1(w3);
+    const auto vinv_r0 = Ops::set1(inv_r0), vinv_r1 = Ops::set1(inv_r1);
+    const auto vr0_over_r01 = Ops::set1(r0_over_r01), vinv_r01 = Ops::set1(inv_r01);
+    int64_t i = 0;
+    for (; i + Ops::W <= n; i += Ops::W)
+        thirdOrderBlock<Ops>(x + i, sample + i, m0 + i, m1 + i, m2 + i, vw0, vw1, vw2, vw3,
+                             vinv_r0, vinv_r1, vr0_over_r01, vinv_r01);
+    for (; kNeedsTail<N> && i < n; i++)
+        thirdOrderBlock<ScalarOps>(x + i, sample + i, m0 + i, m1 + i, m2 + i, w0, w1, w2, w3,
+                                   inv_r0, inv_r1, r0_over_r01, inv_r01);
+}
+
+// Broadcast copy of StepCoefficients for one ISA
+template <class O>
+struct StepVectors {
+    typename O::V dequant_scale, dequant_bias, quant_multiplier, quant_bias;
+    typename O::V guidance, p, q, r, w0, w1, w2, w3, inv_r0, inv_r1, r0_over_r01, inv_r01;
+
+    explicit StepVectors(const StepCoefficients& c)
+        : dequant_scale(O::set1(c.dequant_scale)), dequant_bias(O::set1(c.dequant_bias)),
+          quant_multiplier(O::set1(c.quant_multiplier)), quant_bias(O::set1(c.quant_bias)),
+          guidance(O::set1(c.guidance)), p(O::set1(c.p)), q(O::set1(c.q)), r(O::set1(c.r)),
+          w0(O::set1(c.w0)), w1(O::set1(c.w1)), w2(O::set1(c.w2)), w3(O::set1(c.w3)),
+          inv_r0(O::set1(c.inv_r0)), inv_r1(O::set1(c.inv_r1)),
+          r0_over_r01(O::set1(c.r0_over_r01)), inv_r01(O::set1(c.inv_r01)) {}
+};
+
+// Model output loads, T is float32_t or the raw uint16_t UNet output which is dequantized here
+template <class O>
+static inline typename O::V loadModelOutput(const float32_t* p, const StepVectors<O>&)
+{
+    return O::load(p);
+}
+
+template <class O>
+static inline typename O::V loadModelOutput(const uint16_t* p, const StepVectors<O>& c)
+{
+    return O::fmadd(O::loadU16(p), c.dequant_scale, c.dequant_bias);
+}
+
+// Stores the updated latent, and its quantized copy when Q is set
+template <class O, bool Q>
+static inline void storeLatent(float32_t* x, uint16_t* xq, typename O::V v, const StepVectors<O>& c)
+{
+    O::store(x, v);
+    if constexpr (Q)
+        O::storeU16(xq, O::fmadd(v, c.quant_multiplier, c.quant_bias));
+}
+
+// Quantized latent of element i, xq may be null when Q is not set so it isn't offset then
+template <bool Q>
+static inline uint16_t* quantizedLatentAt(uint16_t* xq, int64_t i)
+{
+    if constexpr (Q)
+        return xq + i;
+    else
+        return nullptr;
+}
+
+// Guidance blend followed by the model output conversion, kept in the history slot m0
+template <class O, class T>
+static inline typename O::V fusedModelOutput(float32_t* m0, typename O::V s,
+                                             const T* uncond, const T* cond,
+                                             const StepVectors<O>& c)
+{
+    auto u = loadModelOutput<O>(uncond, c);
+    auto m = O::fmadd(c.guidance, O::sub(loadModelOutput<O>(cond, c), u), u);
+    m = O::mul(O::fmadd(c.q, m, O::mul(c.p, s)), c.r);
+    O::store(m0, m);
+    return m;
+}
+
+template <class O, class T, bool Q>
+static inline void fusedFirstOrderBlock(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                        const T* uncond, const T* cond,
+                                        const StepVectors<O>& c)
+{
+    auto s  = O::load(sample);
+    auto d0 = fusedModelOutput<O, T>(m0, s, uncond, cond, c);
+    storeLatent<O, Q>(x, xq, O::fnmadd(c.w1, d0, O::mul(c.w0, s)), c);
+}
+
+template <int64_t N, class T, bool Q>
+static void fusedFirstOrderImpl(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                const T* uncond, const T* cond,
+                                const StepCoefficients& c, int64_t n)
+{
+    n = (N != 0) ? N : n;
+    const StepVectors<Ops> vc(c);
+    const StepVectors<ScalarOps> sc(c);
+    int64_t i = 0;
+    for (; i + Ops::W <= n; i += Ops::W)
+        fusedFirstOrderBlock<Ops, T, Q>(x + i, quantizedLatentAt<Q>(xq, i), m0 + i, sample + i, uncond + i, cond + i, vc);
+    for (; kNeedsTail<N> && i < n; i++)
+        fusedFirstOrderBlock<ScalarOps, T, Q>(x + i, quantizedLatentAt<Q>(xq, i), m0 + i, sample + i, uncond + i, cond + i, sc);
+}
+
+template <class O, class T, bool Q>
+static inline void fusedSecondOrderBlock(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                         const T* uncond, const T* cond, const float32_t* m1,
+                                         const StepVectors<O>& c)
+{
+    auto s   = O::load(sample);
+    auto d0  = fusedModelOutput<O, T>(m0, s, uncond, cond, c);
+    auto d1  = O::mul(c.inv_r0, O::sub(d0, O::load(m1)));
+    auto acc = O::fnmadd(c.w1, d0, O::mul(c.w0, s));
+    storeLatent<O, Q>(x, xq, O::fnmadd(c.w2, d1, acc), c);
+}
+
+template <int64_t N, class T, bool Q>
+static void fusedSecondOrderImpl(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                 const T* uncond, const T* cond, const float32_t* m1,
+                                 const StepCoefficients& c, int64_t n)
+{
+    n = (N != 0) ? N : n;
+    const StepVectors<Ops> vc(c);
+    const StepVectors<ScalarOps> sc(c);
+    int64_t i = 0;
+    for (; i + Ops::W <= n; i += Ops::W)
+        fusedSecondOrderBlock<Ops, T, Q>(x + i, quantizedLatentAt<Q>(xq, i), m0 + i, sample + i, uncond + i, cond + i, m1 + i, vc);
+    for (; kNeedsTail<N> && i < n; i++)
+        fusedSecondOrderBlock<ScalarOps, T, Q>(x + i, quantizedLatentAt<Q>(xq, i), m0 + i, sample + i, uncond + i, cond + i, m1 + i, sc);
+}
+
+template <class O, class T, bool Q>
+static inline void fusedThirdOrderBlock(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                        const T* uncond, const T* cond,
+                                        const float32_t* m1, const float32_t* m2,
+                                        const StepVectors<O>& c)
+{
+    auto s    = O::load(sample);
+    auto d0   = fusedModelOutput<O, T>(m0, s, uncond, cond, c);
+    auto v1   = O::load(m1);
+    auto d1_0 = O::mul(c.inv_r0, O::sub(d0, v1));
+    auto d1_1 = O::mul(c.inv_r1, O::sub(v1, O::load(m2)));
+    auto diff = O::sub(d1_0, d1_1);
+    auto d1   = O::fmadd(c.r0_over_r01, diff, d1_0);
+    auto d2   = O::mul(c.inv_r01, diff);
+    auto acc  = O::fnmadd(c.w1, d0, O::mul(c.w0, s));
+    acc       = O::fnmadd(c.w2, d1, acc);
+    storeLatent<O, Q>(x, xq, O::fnmadd(c.w3, d2, acc), c);
+}
+
+template <int64_t N, class T, bool Q>
+static void fusedThirdOrderImpl(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                const T* uncond, const T* cond,
+                                const float32_t* m1, const float32_t* m2,
+                                const StepCoefficients& c, int64_t n)
+{
+    n = (N != 0) ? N : n;
+    const StepVectors<Ops> vc(c);
+    const StepVectors<ScalarOps> sc(c);
+    int64_t i = 0;
+    for (; i + Ops::W <= n; i += Ops::W)
+        fusedThirdOrderBlock<Ops, T, Q>(x + i, quantizedLatentAt<Q>(xq, i), m0 + i, sample + i, uncond + i, cond + i, m1 + i, m2 + i, vc);
+    for (; kNeedsTail<N> && i < n; i++)
+        fusedThirdOrderBlock<ScalarOps, T, Q>(x + i, quantizedLatentAt<Q>(xq, i), m0 + i, sample + i, uncond + i, cond + i, m1 + i, m2 + i, sc);
+}
+
+// Table entries, the quantized latent store is picked once per call
+template <int64_t N>
+static void fusedFirstOrder(float32_t* x, float32_t* m0, const float32_t* sample,
+                            const float32_t* uncond, const float32_t* cond,
+                            const StepCoefficients& c, int64_t n)
+{
+    fusedFirstOrderImpl<N, float32_t, false>(x, nullptr, m0, sample, uncond, cond, c, n);
+}
+
+template <int64_t N>
+static void fusedSecondOrder(float32_t* x, float32_t* m0, const float32_t* sample,
+                             const float32_t* uncond, const float32_t* cond, const float32_t* m1,
+                             const StepCoefficients& c, int64_t n)
+{
+    fusedSecondOrderImpl<N, float32_t, false>(x, nullptr, m0, sample, uncond, cond, m1, c, n);
+}
+
+template <int64_t N>
+static void fusedThirdOrder(float32_t* x, float32_t* m0, const float32_t* sample,
+                            const float32_t* uncond, const float32_t* cond,
+                            const float32_t* m1, const float32_t* m2,
+                            const StepCoefficients& c, int64_t n)
+{
+    fusedThirdOrderImpl<N, float32_t, false>(x, nullptr, m0, sample, uncond, cond, m1, m2, c, n);
+}
+
+template <int64_t N>
+static void fusedFirstOrderQuantized(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                     const uint16_t* uncond, const uint16_t* cond,
+                                     const StepCoefficients& c, int64_t n)
+{
+    if (xq)
+        fusedFirstOrderImpl<N, uint16_t, true>(x, xq, m0, sample, uncond, cond, c, n);
+    else
+        fusedFirstOrderImpl<N, uint16_t, false>(x, xq, m0, sample, uncond, cond, c, n);
+}
+
+template <int64_t N>
+static void fusedSecondOrderQuantized(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                      const uint16_t* uncond, const uint16_t* cond, const float32_t* m1,
+                                      const StepCoefficients& c, int64_t n)
+{
+    if (xq)
+        fusedSecondOrderImpl<N, uint16_t, true>(x, xq, m0, sample, uncond, cond, m1, c, n);
+    else
+        fusedSecondOrderImpl<N, uint16_t, false>(x, xq, m0, sample, uncond, cond, m1, c, n);
+}
+
+template <int64_t N>
+static void fusedThirdOrderQuantized(float32_t* x, uint16_t* xq, float32_t* m0, const float32_t* sample,
+                                     const uint16_t* uncond, const uint16_t* cond,
+                                     const float32_t* m1, const float32_t* m2,
+                                     const StepCoefficients& c, int64_t n)
+{
+    if (xq)
+        fusedThirdOrderImpl<N, uint16_t, true>(x, xq, m0, sample, uncond, cond, m1, m2, c, n);
+    else
+        fusedThirdOrderImpl<N, uint16_t, false>(x, xq, m0, sample, uncond, cond, m1, m2, c, n);
+}
+
+template <int64_t N>
+static constexpr SchedulerKernels kernelTable()
+{
+    return {
+        guidance<N>,
+        convert<N>,
+        firstOrder<N>,
+        secondOrder<N>,
+        thirdOrder<N>,
+        fusedFirstOrder<N>,
+        fusedSecondOrder<N>,
+        fusedThirdOrder<N>,
+        fusedFirstOrderQuantized<N>,
+        fusedSecondOrderQuantized<N>,
+        fusedThirdOrderQuantized<N>,
+        quantize<N>,
+    };
+}
+
+static const SchedulerKernels kKernels = kernelTable<0>();
+static const SchedulerKernels kKernels64x64 = kernelTable<kLatentCount64x64>();
+static const SchedulerKernels kKernels96x96 = kernelTable<kLatentCount96x96>();
@@ -0,0 +1,334 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+#include "SingleStepScheduler.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Latent shape used until setLatentShape() is called, SD 1.5 at 512x512
+#define DEFAULT_LATENT_HEIGHT 64
+#define DEFAULT_LATENT_WIDTH 64
+#define DEFAULT_LATENT_CHANNEL 4
+
+// Consistency model boundary condition, c_skip and c_out of the LCM paper
+#define LCM_SIGMA_DATA 0.5
+
+#ifdef BUILD_RELEASE
+#define MY_LOGV(format, ...)
+#define MY_LOGD(format, ...)
+#define MY_LOGE(format, ...)
+#else
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOGTAG "Scheduler"
+#define MY_LOGV(format, ...) __android_log_print(ANDROID_LOG_VERBOSE, LOGTAG, format, ##__VA_ARGS__)
+#define MY_LOGD(format, ...) __android_log_print(ANDROID_LOG_DEBUG, LOGTAG, format, ##__VA_ARGS__)
+#define MY_LOGE(format, ...) __android_log_print(ANDROID_LOG_ERROR, LOGTAG, format, ##__VA_ARGS__)
+#else
+#define MY_LOGV(format, ...) printf("Scheduler INFO: "#format "\n", ##__VA_ARGS__)
+#define MY_LOGD(format, ...) printf("Scheduler DEBUG: "#format "\n", ##__VA_ARGS__)
+#define MY_LOGE(format, ...) printf("Scheduler ERROR: "#format "\n", ##__VA_ARGS__)
+#endif
+#endif
+
+SingleStepScheduler::SingleStepScheduler(int32_t num_train_timesteps, double beta_start, double beta_end,
+                                         const std::string& beta_schedule, const std::vector<float32_t>& trained_betas,
+                                         const std::string& prediction_type)
+    : m_NormalDistribution(0.0f, 1.0f) {
+    auto betas = makeBetas(num_train_timesteps, beta_start, beta_end, beta_schedule, trained_betas);
+
+    double alphaCumprod = 1.0;
+    for (size_t i = 0; i < betas.size(); ++i) {
+        alphaCumprod *= static_cast<float32_t>(1.0 - betas[i]);
+        m_AlphasCumprod.push_back(static_cast<float32_t>(alphaCumprod));
+    }
+    m_NumTrainTimesteps = num_train_timesteps;
+
+    if (prediction_type == "epsilon") {
+        m_PredictionType = PredictionType::EPSILON;
+    } else if (prediction_type == "sample") {
+        m_PredictionType = PredictionType::SAMPLE;
+    } else if (prediction_type == "v_prediction") {
+        m_PredictionType = PredictionType::V_PREDICTION;
+    } else {
+        MY_LOGE("prediction_type given as %s must be one of `epsilon`, `sample`, or `v_prediction`.",
+                prediction_type.c_str());
+        m_PredictionType = PredictionType::INVALID;
+    }
+
+    setLatentShape(DEFAULT_LATENT_HEIGHT, DEFAULT_LATENT_WIDTH, DEFAULT_LATENT_CHANNEL);
+}
+
+bool SingleStepScheduler::resizeBuffers(int64_t latent_element_count, int32_t batch_size) {
+    m_DataPrediction.resize(latent_element_count * batch_size);
+    m_Noise.clear();
+    return true;
+}
+
+bool SingleStepScheduler::dataPredictionCoefficients(int32_t timestep, double sample_scale,
+                                                     StepCoefficients& coeffs, bool& identity) const {
+    if (timestep < 0 || static_cast<size_t>(timestep) >= m_AlphasCumprod.size()) {
+        MY_LOGE("timestep %d is out of the %zu train timesteps", timestep, m_AlphasCumprod.size());
+        return false;
+    }
+
+    double alpha_t = std::sqrt(static_cast<double>(m_AlphasCumprod[timestep]));
+    double sigma_t = std::sqrt(1.0 - m_AlphasCumprod[timestep]);
+
+    // Same form as the DPM-Solver++ conversion, x0 = (p * sample + q * model_output) * r
+    coeffs.p = 0;
+    coeffs.q = 1;
+    coeffs.r = 1;
+    identity = false;
+    if (m_PredictionType == PredictionType::EPSILON) {
+        coeffs.p = static_cast<float32_t>(sample_scale);
+        coeffs.q = static_cast<float32_t>(-sigma_t);
+        coeffs.r = static_cast<float32_t>(1 / alpha_t);
+    } else if (m_PredictionType == PredictionType::SAMPLE) {
+        // Do nothing since output is same as model_data
+        identity = true;
+    } else if (m_PredictionType == PredictionType::V_PREDICTION) {
+        coeffs.p = static_cast<float32_t>(alpha_t * sample_scale);
+        coeffs.q = static_cast<float32_t>(-sigma_t);
+    } else {
+        MY_LOGE("prediction_type must be one of `epsilon`, `sample`, or `v_prediction`.");
+        return false;
+    }
+    return true;
+}
+
+bool SingleStepScheduler::runStep(const ModelOutputs& model_output, int32_t step_index, bool final_jump,
+                                  void* prev_output, void* curr_output,
+                                  const QuantizedLatents& quantized_latents) {
+    const auto& plan_step = m_StepPlan->steps[step_index];
+    StepCoefficients coeffs = final_jump ? plan_step.exitCoeffs : plan_step.coeffs;
+    coeffs.guidance = m_GuidanceScale;
+    coeffs.dequant_scale = model_output.scale;
+    coeffs.dequant_bias = model_output.bias;
+    coeffs.quant_multiplier = quantized_latents.multiplier;
+    coeffs.quant_bias = quantized_latents.bias;
+
+    // The jump to the final target is deterministic
+    const float32_t noise_scale = final_jump ? 0.0f : plan_step.noiseScale;
+
+    const auto n = m_LatentElementCount;
+    if (0 != noise_scale) {
+        m_Noise.resize(n);
+    }
+
+    for (int32_t b = 0; b < m_BatchSize; ++b) {
+        // The float outputs are null when the step reads the quantized ones
+        auto uncond_ptr = model_output.quantized() ? nullptr : model_output.uncond + b * n;
+        auto cond_ptr   = model_output.quantized() ? nullptr : model_output.cond + b * n;
+        auto sample     = (const float32_t*) prev_output + b * n;
+        auto x          = (float32_t*) curr_output + b * n;
+        auto x0         = m_DataPrediction.data() + b * n;
+        auto xq         = quantized_latents.data ? quantized_latents.data + b * n : nullptr;
+
+        if (model_output.quantized()) {
+            // The noise is added after the update, quantize in the same pass only without it
+            m_Kernels->fusedFirstOrderQuantized(x, (0 == noise_scale) ? xq : nullptr, x0, sample,
+                                                model_output.uncondQuantized + b * n,
+                                                model_output.condQuantized + b * n, coeffs, n);
+            if (0 == noise_scale) {
+                xq = nullptr;
+            }
+        } else if (m_FusedStep) {
+            m_Kernels->fusedFirstOrder(x, x0, sample, uncond_ptr, cond_ptr, coeffs, n);
+        } else {
+            m_Kernels->guidance(x0, uncond_ptr, cond_ptr, coeffs.guidance, n);
+            if (!plan_step.identityConversion) {
+                m_Kernels->convert(x0, sample, coeffs.p, coeffs.q, coeffs.r, n);
+            }
+            m_Kernels->firstOrder(x, sample, x0, coeffs.w0, coeffs.w1, n);
+        }
+
+        // x = noiseScale * noise + x
+        if (0 != noise_scale) {
+            for (auto& value : m_Noise) {
+                value = m_NormalDistribution(m_NoiseGenerator);
+            }
+            m_Kernels->convert(x, m_Noise.data(), noise_scale, 1, 1, n);
+        }
+
+        if (nullptr != xq) {
+            m_Kernels->quantize(xq, x, quantized_latents.multiplier, quantized_latents.bias, n);
+        }
+    }
+
+    return true;
+}
+
+EulerDiscreteScheduler::EulerDiscreteScheduler(int32_t num_train_timesteps, double beta_start,
+                                               double beta_end, std::string beta_schedule,
+                                               std::vector<float32_t> trained_betas, std::string prediction_type,
+                                               bool ancestral)
+    : SingleStepScheduler(num_train_timesteps, beta_start, beta_end, beta_schedule, trained_betas, prediction_type),
+      m_Ancestral(ancestral) {
+}
+
+std::shared_ptr<const StepPlan> EulerDiscreteScheduler::buildStepPlan(int32_t num_inference_steps) const {
+    // Whole timesteps, so the sigmas match the UNet time embedding
+    auto timesteps = spacedTimesteps(num_inference_steps);
+    if (timesteps.empty()) {
+        return nullptr;
+    }
+
+    auto sigmaOf = [this](int32_t timestep) {
+        double alpha_cumprod = m_AlphasCumprod[timestep];
+        return std::sqrt((1.0 - alpha_cumprod) / alpha_cumprod);
+    };
+
+    auto plan = std::make_shared<StepPlan>();
+    plan->steps.resize(num_inference_steps);
+    plan->initNoiseSigma = static_cast<float32_t>(std::sqrt(sigmaOf(timesteps[0]) * sigmaOf(timesteps[0]) + 1));
+
+    for (int32_t i = 0; i < num_inference_steps; ++i) {
+        auto& plan_step = plan->steps[i];
+        const bool last = (i == num_inference_steps - 1);
+        plan_step.timestep = timesteps[i];
+        plan_step.prevTimestep = last ? 0 : timesteps[i + 1];
+        plan_step.order = 1;
+
+        double sigma      = sigmaOf(timesteps[i]);
+        double sigma_next = last ? 0.0 : sigmaOf(timesteps[i + 1]);
+        double sigma_up   = 0.0;
+        double sigma_down = sigma_next;
+        if (m_Ancestral) {
+            sigma_up   = std::sqrt(sigma_next * sigma_next * (sigma * sigma - sigma_next * sigma_next) / (sigma * sigma));
+            sigma_down = std::sqrt(sigma_next * sigma_next - sigma_up * sigma_up);
+        }
+
+        // The latent is kept in sigma space, the UNet sees it scaled back to unit variance
+        double model_input_scale = 1 / std::sqrt(sigma * sigma + 1);
+        plan_step.modelInputScale = static_cast<float32_t>(model_input_scale);
+        plan_step.noiseScale = static_cast<float32_t>(sigma_up);
+
+        if (true != dataPredictionCoefficients(timesteps[i], model_input_scale, plan_step.coeffs,
+                                               plan_step.identityConversion)) {
+            MY_LOGE("Error in building the step plan");
+            return nullptr;
+        }
+
+        // x = sample + (sigma_down - sigma) * (sample - x0) / sigma
+        plan_step.coeffs.w0 = static_cast<float32_t>(sigma_down / sigma);
+        plan_step.coeffs.w1 = static_cast<float32_t>((sigma_down - sigma) / sigma);
+
+        // Down to sigma 0, x = x0
+        plan_step.exitCoeffs = plan_step.coeffs;
+        plan_step.exitCoeffs.w0 = 0;
+        plan_step.exitCoeffs.w1 = -1;
+    }
+
+    return plan;
+}
+
+DDIMScheduler::DDIMScheduler(int32_t num_train_timesteps, double beta_start,
+                             double beta_end, std::string beta_schedule,
+                             std::vector<float32_t> trained_betas, std::string prediction_type,
+                             int32_t steps_offset, bool set_alpha_to_one)
+    : SingleStepScheduler(num_train_timesteps, beta_start, beta_end, beta_schedule, trained_betas, prediction_type) {
+    m_TimestepSpacing = TimestepSpacing::LEADING;
+    m_StepsOffset = steps_offset;
+    m_FinalAlphaCumprod = (set_alpha_to_one || m_AlphasCumprod.empty()) ? 1.0f : m_AlphasCumprod[0];
+}
+
+std::shared_ptr<const StepPlan> DDIMScheduler::buildStepPlan(int32_t num_inference_steps) const {
+    auto timesteps = spacedTimesteps(num_inference_steps);
+    if (timesteps.empty()) {
+        return nullptr;
+    }
+
+    auto plan = std::make_shared<StepPlan>();
+    plan->steps.resize(num_inference_steps);
+
+    for (int32_t i = 0; i < num_inference_steps; ++i) {
+        auto& plan_step = plan->steps[i];
+        // The step after the last one lands on the final alpha
+        int32_t timestep = timesteps[i];
+        int32_t prev_timestep = (i == num_inference_steps - 1) ? -1 : timesteps[i + 1];
+        plan_step.timestep = timestep;
+        plan_step.prevTimestep = std::max(prev_timestep, 0);
+        plan_step.order = 1;
+
+        if (true != dataPredictionCoefficients(timestep, 1.0, plan_step.coeffs, plan_step.identityConversion)) {
+            MY_LOGE("Error in building the step plan");
+            return nullptr;
+        }
+
+        double alpha_prod_t      = m_AlphasCumprod[timestep];
+        double alpha_prod_t_prev = (prev_timestep >= 0) ? m_AlphasCumprod[prev_timestep] : m_FinalAlphaCumprod;
+
+        // x = sqrt(alpha_prod_t_prev) * x0 + sqrt(1 - alpha_prod_t_prev) * eps, with eps taken back from x0
+        auto updateWeights = [alpha_prod_t](double alpha_prod_t_prev, StepCoefficients& coeffs) {
+            double w0 = std::sqrt(1 - alpha_prod_t_prev) / std::sqrt(1 - alpha_prod_t);
+            coeffs.w0 = static_cast<float32_t>(w0);
+            coeffs.w1 = static_cast<float32_t>(w0 * std::sqrt(alpha_prod_t) - std::sqrt(alpha_prod_t_prev));
+        };
+        updateWeights(alpha_prod_t_prev, plan_step.coeffs);
+        plan_step.exitCoeffs = plan_step.coeffs;
+        updateWeights(m_FinalAlphaCumprod, plan_step.exitCoeffs);
+    }
+
+    return plan;
+}
+
+LCMScheduler::LCMScheduler(int32_t num_train_timesteps, double beta_start,
+                           double beta_end, std::string beta_schedule,
+                           std::vector<float32_t> trained_betas, std::string prediction_type,
+                           int32_t original_inference_steps, double timestep_scaling)
+    : SingleStepScheduler(num_train_timesteps, beta_start, beta_end, beta_schedule, trained_betas, prediction_type),
+      m_OriginalInferenceSteps(original_inference_steps), m_TimestepScaling(timestep_scaling) {
+}
+
+std::shared_ptr<const StepPlan> LCMScheduler::buildStepPlan(int32_t num_inference_steps) const {
+    if (num_inference_steps <= 0 || num_inference_steps > m_OriginalInferenceSteps) {
+        MY_LOGE("num_inference_steps given as %d must be in [1, %d]", num_inference_steps, m_OriginalInferenceSteps);
+        return nullptr;
+    }
+
+    // Timesteps of the distillation schedule, evenly skipped from the noisiest one
+    const int32_t origin_ratio = m_NumTrainTimesteps / m_OriginalInferenceSteps;
+    const int32_t skipping_step = m_OriginalInferenceSteps / num_inference_steps;
+    std::vector<int32_t> timesteps(num_inference_steps);
+    for (int32_t i = 0; i < num_inference_steps; ++i) {
+        timesteps[i] = (m_OriginalInferenceSteps - i * skipping_step) * origin_ratio - 1;
+    }
+
+    auto plan = std::make_shared<StepPlan>();
+    plan->steps.resize(num_inference_steps);
+
+    for (int32_t i = 0; i < num_inference_steps; ++i) {
+        auto& plan_step = plan->steps[i];
+        const bool last = (i == num_inference_steps - 1);
+        plan_step.timestep = timesteps[i];
+        plan_step.prevTimestep = last ? 0 : timesteps[i + 1];
+        plan_step.order = 1;
+
+        if (true != dataPredictionCoefficients(timesteps[i], 1.0, plan_step.coeffs, plan_step.identityConversion)) {
+            MY_LOGE("Error in building the step plan");
+            return nullptr;
+        }
+
+        // denoised = c_skip * sample + c_out * x0
+        double scaled_timestep = timesteps[i] * m_TimestepScaling;
+        double sigma_data_2 = LCM_SIGMA_DATA * LCM_SIGMA_DATA;
+        double c_skip = sigma_data_2 / (scaled_timestep * scaled_timestep + sigma_data_2);
+        double c_out  = scaled_timestep / std::sqrt(scaled_timestep * scaled_timestep + sigma_data_2);
+
+        // The final jump returns the denoised sample
+        plan_step.exitCoeffs = plan_step.coeffs;
+        plan_step.exitCoeffs.w0 = static_cast<float32_t>(c_skip);
+        plan_step.exitCoeffs.w1 = static_cast<float32_t>(-c_out);
+
+        // Every step but the last one noises the denoised sample again to the next timestep
+        double alpha_prod_t_prev = last ? 1.0 : m_AlphasCumprod[timesteps[i + 1]];
+        plan_step.coeffs.w0 = static_cast<float32_t>(std::sqrt(alpha_prod_t_prev) * c_skip);
+        plan_step.coeffs.w1 = static_cast<float32_t>(-std::sqrt(alpha_prod_t_prev) * c_out);
+        plan_step.noiseScale = static_cast<float32_t>(std::sqrt(1 - alpha_prod_t_prev));
+    }
+
+    return plan;
+}
@@ -0,0 +1,317 @@
+// ---------------------------------------------------------------------
+// Copyright (c) 2026 Qualcomm Innovation Center, Inc. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+// ---------------------------------------------------------------------
+
+// Host side benchmark of the scheduler step, runs without the NPU.
+//
+//  scheduler_benchmark [benchmark flags] [--golden_dir=<dir>] [--golden_tolerance=<tol>] [--golden_only]
+//
+// With --golden_dir every *.bin case written by make_scheduler_golden.py is replayed through
+// DPMSolverMultistepScheduler first, and the tool fails when a step drifts from diffusers by more
+// than the relative tolerance (max abs error / max abs expected value).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "Scheduler.hpp"
+
+#define GOLDEN_MAGIC   0x47484353  // "SCHG"
+#define GOLDEN_VERSION 1
+
+static const char* s_PredictionTypes[] = { "epsilon", "sample", "v_prediction" };
+
+// Layout of a golden case, all little endian:
+//   GoldenHeader, int32 timesteps[num_inference_steps], float32 initial latent[N],
+//   then per step float32 uncond and cond model outputs[2 * N] and the expected latent[N],
+//   with N = height * width * channel in NHWC order
+struct GoldenHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t solverOrder;
+    int32_t predictionType;
+    int32_t height;
+    int32_t width;
+    int32_t channel;
+    int32_t numInferenceSteps;
+    float32_t guidanceScale;
+};
+
+static DPMSolverMultistepScheduler* createBenchmarkScheduler(int32_t solver_order, int32_t prediction_type)
+{
+    // Same configuration as the Stable Diffusion pipeline, see QnnApiHelpers::Init
+    return new DPMSolverMultistepScheduler(1000, 0.00085, 0.012, "scaled_linear", {}, {},
+                                           solver_order, s_PredictionTypes[prediction_type]);
+}
+
+static bool readValues(std::ifstream& file, void* data, size_t size)
+{
+    file.read(reinterpret_cast<char*>(data), size);
+    return file.good();
+}
+
+static bool runGoldenCase(const std::string& path, double tolerance)
+{
+    std::ifstream file(path, std::ios::binary);
+    GoldenHeader header;
+    if (!file.is_open() || !readValues(file, &header, sizeof(header)) ||
+        header.magic != GOLDEN_MAGIC || header.version != GOLDEN_VERSION)
+    {
+        printf("%s: not a golden file of version %d\n", path.c_str(), GOLDEN_VERSION);
+        return false;
+    }
+    if (header.predictionType < 0 || header.predictionType > 2 || header.numInferenceSteps <= 0)
+    {
+        printf("%s: invalid header\n", path.c_str());
+        return false;
+    }
+
+    const int64_t n = (int64_t)header.height * header.width * header.channel;
+    std::vector<int32_t> timesteps(header.numInferenceSteps);
+    std::vector<float32_t> latent(n), model_output(2 * n), expected(n);
+    if (!readValues(file, timesteps.data(), timesteps.size() * sizeof(int32_t)) ||
+        !readValues(file, latent.data(), n * sizeof(float32_t)))
+    {
+        printf("%s: truncated file\n", path.c_str());
+        return false;
+    }
+
+    std::unique_ptr<DPMSolverMultistepScheduler> scheduler(
+        createBenchmarkScheduler(header.solverOrder, header.predictionType));
+    if (!scheduler->setLatentShape(header.height, header.width, header.channel) ||
+        !scheduler->setTimesteps(header.numInferenceSteps))
+    {
+        printf("%s: scheduler setup failed\n", path.c_str());
+        return false;
+    }
+    scheduler->setGuidanceScale(header.guidanceScale);
+
+    double worst = 0;
+    for (int32_t i = 0; i < header.numInferenceSteps; i++)
+    {
+        if (scheduler->getTimestep(i) != timesteps[i])
+        {
+            printf("%s: step %d runs timestep %d, diffusers uses %d\n", path.c_str(), i,
+                   scheduler->getTimestep(i), timesteps[i]);
+            return false;
+        }
+        if (!readValues(file, model_output.data(), model_output.size() * sizeof(float32_t)) ||
+            !readValues(file, expected.data(), n * sizeof(float32_t)))
+        {
+            printf("%s: truncated file\n", path.c_str());
+            return false;
+        }
+        if (!scheduler->step(model_output.data(), i, latent.data(), latent.data()))
+        {
+            printf("%s: step %d failed\n", path.c_str(), i);
+            return false;
+        }
+
+        double max_err = 0, max_ref = 0;
+        for (int64_t k = 0; k < n; k++)
+        {
+            max_err = std::max(max_err, (double)std::fabs(latent[k] - expected[k]));
+            max_ref = std::max(max_ref, (double)std::fabs(expected[k]));
+        }
+        double rel_err = max_err / std::max(max_ref, 1e-6);
+        worst = std::max(worst, rel_err);
+        if (!(rel_err <= tolerance))
+        {
+            printf("%s: step %d drifts by %.3g, tolerance %.3g\n", path.c_str(), i, rel_err, tolerance);
+            return false;
+        }
+        // Continue from the reference so that the error of one step doesn't add up
+        latent = expected;
+    }
+
+    printf("%s: ok, order %d, %s, %dx%dx%d, %d steps, max drift %.3g\n", path.c_str(),
+           header.solverOrder, s_PredictionTypes[header.predictionType], header.height, header.width,
+           header.channel, header.numInferenceSteps, worst);
+    return true;
+}
+
+static bool runGolden(const std::string& golden_dir, double tolerance)
+{
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(golden_dir, error))
+    {
+        if (entry.path().extension() == ".bin")
+        {
+            paths.push_back(entry.path().string());
+        }
+    }
+    if (error || paths.empty())
+    {
+        printf("No golden files found in %s\n", golden_dir.c_str());
+        return false;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    bool passed = true;
+    for (const auto& path : paths)
+    {
+        passed = runGoldenCase(path, tolerance) && passed;
+    }
+    return passed;
+}
+
+// Args: solver order, prediction type index, latent height and width (4 channels)
+static void BM_SchedulerStep(benchmark::State& state)
+{
+    const int32_t solver_order = (int32_t)state.range(0);
+    const int32_t prediction_type = (int32_t)state.range(1);
+    const int32_t side = (int32_t)state.range(2);
+    const int32_t num_inference_steps = 20;
+
+    std::unique_ptr<DPMSolverMultistepScheduler> scheduler(createBenchmarkScheduler(solver_order, prediction_type));
+    if (!scheduler->setLatentShape(side, side, 4) || !scheduler->setTimesteps(num_inference_steps))
+    {
+        state.SkipWithError("scheduler setup failed");
+        return;
+    }
+    scheduler->setGuidanceScale(7.5);
+
+    const int64_t n = scheduler->getLatentElementCount();
+    std::mt19937 generator(0);
+    std::normal_distribution<float32_t> distribution;
+    std::vector<float32_t> initial_latent(n), latent(n), model_output(2 * n);
+    for (auto& value : initial_latent) value = distribution(generator);
+    for (auto& value : model_output) value = distribution(generator);
+    latent = initial_latent;
+
+    // Cycles through the whole plan so that every solver order of the schedule is measured,
+    // restarting from the initial latent since the fixed model outputs don't keep it bounded
+    int32_t step_index = 0;
+    for (auto _ : state)
+    {
+        if (step_index == num_inference_steps)
+        {
+            state.PauseTiming();
+            scheduler->setTimesteps(num_inference_steps);
+            latent = initial_latent;
+            step_index = 0;
+            state.ResumeTiming();
+        }
+        scheduler->step(model_output.data(), step_index, latent.data(), latent.data());
+        benchmark::DoNotOptimize(latent.data());
+        step_index++;
+    }
+    // Reads the latent and both model outputs, writes the latent
+    state.SetBytesProcessed(state.iterations() * 4 * n * sizeof(float32_t));
+    state.SetLabel(std::string(s_PredictionTypes[prediction_type]) + ", " +
+                   std::to_string(side) + "x" + std::to_string(side) + "x4");
+}
+BENCHMARK(BM_SchedulerStep)
+    ->ArgNames({ "order", "prediction", "side" })
+    ->ArgsProduct({ { 1, 2, 3 }, { 0, 1, 2 }, { 64, 96, 128 } });
+
+// Same as BM_SchedulerStep, but the step reads the raw uint16 Unet outputs and dequantizes them
+static void BM_SchedulerStepQuantized(benchmark::State& state)
+{
+    const int32_t solver_order = (int32_t)state.range(0);
+    const int32_t prediction_type = (int32_t)state.range(1);
+    const int32_t side = (int32_t)state.range(2);
+    const int32_t num_inference_steps = 20;
+
+    std::unique_ptr<DPMSolverMultistepScheduler> scheduler(createBenchmarkScheduler(solver_order, prediction_type));
+    if (!scheduler->setLatentShape(side, side, 4) || !scheduler->setTimesteps(num_inference_steps))
+    {
+        state.SkipWithError("scheduler setup failed");
+        return;
+    }
+    scheduler->setGuidanceScale(7.5);
+
+    const int64_t n = scheduler->getLatentElementCount();
+    std::mt19937 generator(0);
+    std::normal_distribution<float32_t> distribution;
+    std::uniform_int_distribution<uint32_t> quantized_distribution(0, 65535);
+    std::vector<float32_t> initial_latent(n), latent(n);
+    std::vector<uint16_t> uncond(n), cond(n);
+    for (auto& value : initial_latent) value = distribution(generator);
+    for (auto& value : uncond) value = (uint16_t)quantized_distribution(generator);
+    for (auto& value : cond) value = (uint16_t)quantized_distribution(generator);
+    latent = initial_latent;
+
+    // Encoding of a Unet output in [-4, 4]
+    const double scale = 8.0 / 65535;
+    const int32_t offset = -32768;
+
+    int32_t step_index = 0;
+    for (auto _ : state)
+    {
+        if (step_index == num_inference_steps)
+        {
+            state.PauseTiming();
+            scheduler->setTimesteps(num_inference_steps);
+            latent = initial_latent;
+            step_index = 0;
+            state.ResumeTiming();
+        }
+        scheduler->stepQuantized(uncond.data(), cond.data(), scale, offset, step_index, latent.data(), latent.data());
+        benchmark::DoNotOptimize(latent.data());
+        step_index++;
+    }
+    // Reads the latent and both quantized model outputs, writes the latent
+    state.SetBytesProcessed(state.iterations() * n * (2 * sizeof(float32_t) + 2 * sizeof(uint16_t)));
+    state.SetLabel(std::string(s_PredictionTypes[prediction_type]) + ", " +
+                   std::to_string(side) + "x" + std::to_string(side) + "x4");
+}
+BENCHMARK(BM_SchedulerStepQuantized)
+    ->ArgNames({ "order", "prediction", "side" })
+    ->ArgsProduct({ { 1, 2, 3 }, { 0, 1, 2 }, { 64, 96, 128 } });
+
+int main(int argc, char** argv)
+{
+    benchmark::Initialize(&argc, argv);
+
+    std::string golden_dir;
+    double tolerance = 1e-4;
+    bool golden_only = false;
+    int remaining = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (0 == strncmp(argv[i], "--golden_dir=", 13))
+        {
+            golden_dir = argv[i] + 13;
+        }
+        else if (0 == strncmp(argv[i], "--golden_tolerance=", 19))
+        {
+            tolerance = atof(argv[i] + 19);
+        }
+        else if (0 == strcmp(argv[i], "--golden_only"))
+        {
+            golden_only = true;
+        }
+        else
+        {
+            argv[remaining++] = argv[i];
+        }
+    }
+    argc = remaining;
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    if (!golden_dir.empty() && !runGolden(golden_dir, tolerance))
+    {
+        return 1;
+    }
+    if (!golden_only)
+    {
+        benchmark::RunSpecifiedBenchmarks();
+    }
+    benchmark::Shutdown();
+    return 0;
+}
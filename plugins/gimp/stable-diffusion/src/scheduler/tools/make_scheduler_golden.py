@@ -0,0 +1,223 @@
+#!/usr/bin/python3
+"""
+Copyright (c) 2026, Qualcomm Innovation Center, Inc. All rights reserved.
+
+SPDX-License-Identifier: BSD-3-Clause
+"""
+
+# Writes the golden cases replayed by scheduler_benchmark --golden_dir, one file per solver order,
+# prediction type and step count. The checked in cases in golden/ were written by this script.
+#
+# The reference is a numpy port of diffusers' DPMSolverMultistepScheduler restricted to the
+# configuration of the pipeline, so that the cases can be regenerated with numpy alone.
+# --check_diffusers additionally runs every case through diffusers (needs torch and diffusers)
+# and fails when the port drifts from it.
+
+import argparse
+import os
+import struct
+
+import numpy as np
+
+GOLDEN_MAGIC = 0x47484353  # "SCHG"
+GOLDEN_VERSION = 1
+PREDICTION_TYPES = ["epsilon", "sample", "v_prediction"]
+NUM_TRAIN_TIMESTEPS = 1000
+BETA_START = 0.00085
+BETA_END = 0.012
+
+
+class DPMSolverMultistepReference:
+    """Port of DPMSolverMultistepScheduler with algorithm_type="dpmsolver++", solver_type="midpoint",
+    lower_order_final=True, timestep_spacing="linspace" and final_sigmas_type="sigma_min",
+    computing in float32 like diffusers."""
+
+    def __init__(self, solver_order, prediction_type):
+        self.solver_order = solver_order
+        self.prediction_type = prediction_type
+        betas = np.linspace(BETA_START ** 0.5, BETA_END ** 0.5, NUM_TRAIN_TIMESTEPS, dtype=np.float32) ** 2
+        self.alphas_cumprod = np.cumprod(1 - betas, dtype=np.float32)
+
+    def set_timesteps(self, steps):
+        self.timesteps = (np.linspace(0, NUM_TRAIN_TIMESTEPS - 1, steps + 1).round()[::-1][:-1]
+                          .copy().astype(np.int64))
+        sigmas = ((1 - self.alphas_cumprod) / self.alphas_cumprod) ** 0.5
+        # The last step lands on alphas_cumprod[0], see buildStepPlan
+        sigma_last = sigmas[0]
+        self.sigmas = np.concatenate([sigmas[self.timesteps], [sigma_last]]).astype(np.float32)
+        self.model_outputs = [None] * self.solver_order
+        self.lower_order_nums = 0
+        self.step_index = 0
+
+    @staticmethod
+    def _alpha_sigma(sigma):
+        alpha_t = 1 / ((sigma ** 2 + 1) ** 0.5)
+        return alpha_t, sigma * alpha_t
+
+    def _lambda(self, sigma):
+        alpha_t, sigma_t = self._alpha_sigma(sigma)
+        return np.log(alpha_t) - np.log(sigma_t)
+
+    def _convert_model_output(self, model_output, sample):
+        alpha_t, sigma_t = self._alpha_sigma(self.sigmas[self.step_index])
+        if self.prediction_type == "epsilon":
+            return (sample - sigma_t * model_output) / alpha_t
+        if self.prediction_type == "sample":
+            return model_output
+        return alpha_t * sample - sigma_t * model_output
+
+    def step(self, model_output, sample):
+        i = self.step_index
+        last = len(self.timesteps) - 1
+        lower_order_final = i == last and len(self.timesteps) < 15
+        lower_order_second = i == last - 1 and len(self.timesteps) < 15
+
+        self.model_outputs = self.model_outputs[1:] + [self._convert_model_output(model_output, sample)]
+
+        alpha_t, sigma_t = self._alpha_sigma(self.sigmas[i + 1])
+        _, sigma_s0 = self._alpha_sigma(self.sigmas[i])
+        h = self._lambda(self.sigmas[i + 1]) - self._lambda(self.sigmas[i])
+        ratio = sigma_t / sigma_s0
+        m0 = self.model_outputs[-1]
+
+        if self.solver_order == 1 or self.lower_order_nums < 1 or lower_order_final:
+            prev_sample = ratio * sample - (alpha_t * (np.exp(-h) - 1.0)) * m0
+        elif self.solver_order == 2 or self.lower_order_nums < 2 or lower_order_second:
+            m1 = self.model_outputs[-2]
+            h_0 = self._lambda(self.sigmas[i]) - self._lambda(self.sigmas[i - 1])
+            r0 = h_0 / h
+            d1 = (1.0 / r0) * (m0 - m1)
+            prev_sample = (ratio * sample - (alpha_t * (np.exp(-h) - 1.0)) * m0
+                           - 0.5 * (alpha_t * (np.exp(-h) - 1.0)) * d1)
+        else:
+            m1, m2 = self.model_outputs[-2], self.model_outputs[-3]
+            h_0 = self._lambda(self.sigmas[i]) - self._lambda(self.sigmas[i - 1])
+            h_1 = self._lambda(self.sigmas[i - 1]) - self._lambda(self.sigmas[i - 2])
+            r0, r1 = h_0 / h, h_1 / h
+            d1_0 = (1.0 / r0) * (m0 - m1)
+            d1_1 = (1.0 / r1) * (m1 - m2)
+            d1 = d1_0 + (r0 / (r0 + r1)) * (d1_0 - d1_1)
+            d2 = (1.0 / (r0 + r1)) * (d1_0 - d1_1)
+            prev_sample = (ratio * sample - (alpha_t * (np.exp(-h) - 1.0)) * m0
+                           + (alpha_t * ((np.exp(-h) - 1.0) / h + 1.0)) * d1
+                           - (alpha_t * ((np.exp(-h) - 1.0 + h) / h ** 2 - 0.5)) * d2)
+
+        if self.lower_order_nums < self.solver_order:
+            self.lower_order_nums += 1
+        self.step_index += 1
+        return prev_sample.astype(np.float32)
+
+
+class DiffusersReference:
+    """The same interface on top of diffusers, only used by --check_diffusers."""
+
+    def __init__(self, solver_order, prediction_type):
+        import torch
+        from diffusers import DPMSolverMultistepScheduler
+
+        self.torch = torch
+        # Same configuration as the Stable Diffusion pipeline, see QnnApiHelpers::Init
+        self.scheduler = DPMSolverMultistepScheduler(
+            num_train_timesteps=NUM_TRAIN_TIMESTEPS,
+            beta_start=BETA_START,
+            beta_end=BETA_END,
+            beta_schedule="scaled_linear",
+            solver_order=solver_order,
+            prediction_type=prediction_type,
+            algorithm_type="dpmsolver++",
+            solver_type="midpoint",
+            lower_order_final=True,
+            timestep_spacing="linspace",
+            final_sigmas_type="sigma_min",
+        )
+
+    def set_timesteps(self, steps):
+        self.scheduler.set_timesteps(steps)
+        self.timesteps = self.scheduler.timesteps.numpy()
+        self.step_index = 0
+
+    def step(self, model_output, sample):
+        t = self.scheduler.timesteps[self.step_index]
+        self.step_index += 1
+        return self.scheduler.step(self.torch.from_numpy(model_output), t,
+                                   self.torch.from_numpy(sample)).prev_sample.numpy()
+
+
+def max_drift(actual, expected):
+    return float(np.abs(actual - expected).max() / max(float(np.abs(expected).max()), 1e-6))
+
+
+def write_case(out_dir, solver_order, prediction_index, height, width, channel, steps, guidance_scale, seed,
+               check_diffusers):
+    prediction_type = PREDICTION_TYPES[prediction_index]
+    reference = DPMSolverMultistepReference(solver_order, prediction_type)
+    reference.set_timesteps(steps)
+    check = None
+    if check_diffusers:
+        check = DiffusersReference(solver_order, prediction_type)
+        check.set_timesteps(steps)
+        if not np.array_equal(check.timesteps, reference.timesteps):
+            raise SystemExit(f"timesteps {reference.timesteps.tolist()} differ from diffusers "
+                             f"{check.timesteps.tolist()}")
+
+    generator = np.random.default_rng(seed)
+    # The scheduler works on NHWC latents, the reference doesn't care about the layout
+    shape = (1, height, width, channel)
+    sample = generator.standard_normal(shape, dtype=np.float32)
+
+    name = f"dpm_order{solver_order}_{prediction_type}_{height}x{width}x{channel}_{steps}steps.bin"
+    worst = 0.0
+    with open(os.path.join(out_dir, name), "wb") as f:
+        f.write(struct.pack("<2I6if", GOLDEN_MAGIC, GOLDEN_VERSION, solver_order, prediction_index,
+                            height, width, channel, steps, guidance_scale))
+        f.write(reference.timesteps.astype("<i4").tobytes())
+        f.write(sample.astype("<f4").tobytes())
+
+        for _ in reference.timesteps:
+            # Model outputs loosely following the sample, so that the trajectory stays realistic
+            uncond = 0.1 * generator.standard_normal(shape, dtype=np.float32) + np.float32(0.05) * sample
+            cond = 0.1 * generator.standard_normal(shape, dtype=np.float32) + np.float32(0.05) * sample
+            model_output = uncond + np.float32(guidance_scale) * (cond - uncond)
+            next_sample = reference.step(model_output, sample)
+            if check is not None:
+                # Like scheduler_benchmark, every step starts from the reference
+                worst = max(worst, max_drift(next_sample, check.step(model_output, sample)))
+            sample = next_sample
+
+            f.write(np.concatenate([uncond, cond]).astype("<f4").tobytes())
+            f.write(sample.astype("<f4").tobytes())
+    print(f"{name}: timesteps {reference.timesteps.tolist()}" +
+          (f", max drift from diffusers {worst:.3g}" if check is not None else ""))
+    return worst
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generates the golden cases of scheduler_benchmark")
+    parser.add_argument("--out_dir", required=True, help="Directory receiving the golden files")
+    # Below 15 steps the last two steps drop to a lower order, cover both plans
+    parser.add_argument("--steps", type=int, nargs="+", default=[8, 20])
+    parser.add_argument("--guidance_scale", type=float, default=7.5)
+    # Odd sizes so that the SIMD kernels also run their tails
+    parser.add_argument("--height", type=int, default=13)
+    parser.add_argument("--width", type=int, default=11)
+    parser.add_argument("--channel", type=int, default=4)
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--check_diffusers", action="store_true",
+                        help="Compare every step with diffusers, needs torch and diffusers")
+    parser.add_argument("--check_tolerance", type=float, default=1e-5)
+    args = parser.parse_args()
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    worst = 0.0
+    for steps in args.steps:
+        for solver_order in (1, 2, 3):
+            for prediction_index in range(len(PREDICTION_TYPES)):
+                worst = max(worst, write_case(args.out_dir, solver_order, prediction_index, args.height,
+                                              args.width, args.channel, steps, args.guidance_scale,
+                                              args.seed, args.check_diffusers))
+    if worst > args.check_tolerance:
+        raise SystemExit(f"The numpy reference drifts from diffusers by {worst:.3g}")
+
+
+if __name__ == "__main__":
+    main()
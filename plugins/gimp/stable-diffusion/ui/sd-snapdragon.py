@@ -419,7 +419,7 @@ def run(procedure, run_mode, image, n_drawables, layer, args, data):
         seed = Gtk.Entry.new()
         grid.attach(seed, 1, 5, 1, 1)
         seed.set_width_chars(40)
-        seed.set_placeholder_text(_("If left blank, random seed between 0 to 50 will be set.."))
+        seed.set_placeholder_text(_("If left blank, a random seed will be set.."))
         seed.show()
 
         seed_text = _("Seed")
@@ -494,17 +494,26 @@ def run(procedure, run_mode, image, n_drawables, layer, args, data):
                     prompt = "#" + prompt
                     
                 if len(seed.get_text()) != 0:
-                    seed = int(seed.get_text())
+                    # The backend packs the seed into a signed 64 bit field
+                    try:
+                        seed_value = int(seed.get_text())
+                    except ValueError:
+                        seed_value = None
+                    if seed_value is None or not (-2**63 <= seed_value < 2**63):
+                        show_dialog("Seed must be an integer in the signed 64 bit range.", "Error", "error", image_paths)
+                        run_button.set_sensitive(True)
+                        basic_device_combo.set_sensitive(True)
+                        continue
                 else:
-                    seed = random.randint(0,50)
+                    seed_value = random.randint(0, 2**32 - 1)
 
                 step = int(spin_steps.get_text())
                 guidance_scale = float(spin_guidance.get_text())
                 num_images = int(num_images_steps.get_text())
                 
-                server.send("{}:{}:{}:{}:{}:".format(guidance_scale, seed, step, prompt, num_images))
+                server.send("{}:{}:{}:{}:{}:".format(guidance_scale, seed_value, step, prompt, num_images))
 
-                runner = SDRunner(procedure, image, layer, prompt, seed, step, guidance_scale, progress_bar)
+                runner = SDRunner(procedure, image, layer, prompt, seed_value, step, guidance_scale, progress_bar)
 
                 sd_run_label.set_label("Running Stable Diffusion...")
                 sd_run_label.show()